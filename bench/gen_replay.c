@@ -0,0 +1,595 @@
+/*
+   gen_replay: write a deterministic offline workload of canned speedrun.com API
+   responses for `wr_daily --replay=DIR --now=EPOCH`.
+
+     bench/gen_replay --out bench/replay --now 1784919600 [--runs 1200] [--seed 1] [--feed-drift 0]
+
+   Files are keyed exactly like `wr_daily --record`: DIR/<fnv1a_64(url)>.json, plus
+   DIR/index.tsv listing the URLs. The workload is a cold start: about 26h of the
+   verified-runs feed (paged by 200), the top=1 and top=200 leaderboards of every
+   key in it, embedded run details for the feed runs, bare details for leaderboard
+   runs without a verify-date, category variables, and each game's records (the top
+   run of every board without variable filters). One "flood" game contributes a
+   burst of IL runs, like a real busy hour.
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#define API "https://www.speedrun.com/api/v1"
+
+#define MAX_GAMES   160
+#define MAX_PLAYERS 480
+#define MAX_CATS    4
+#define MAX_LEVELS  12
+#define MAX_VARS    2
+#define MAX_VALS    4
+#define PAGE        200
+#define OVERLAP     10      /* wr_daily's FEED_PAGE_OVERLAP: pages start this many runs early */
+#define TOPN        200
+
+typedef struct { char id[9]; char name[32]; int nvals; char val_id[MAX_VALS][9]; char val_label[MAX_VALS][32]; } Var;
+typedef struct { char id[9]; char name[48]; int is_il; int nvars; Var vars[MAX_VARS]; } Cat;
+typedef struct { char id[9]; char name[48]; } Level;
+typedef struct {
+    char id[9]; char name[96]; char abbr[24]; char cover_v[8];
+    int ncats; Cat cats[MAX_CATS];
+    int nlevels; Level levels[MAX_LEVELS];
+} Game;
+typedef struct { char id[9]; char name[32]; int guest; int has_image; char img_v[8]; } Player;
+typedef struct { int game, cat, level; int val[MAX_VARS]; double best; int nruns; int *runs; } Key;
+typedef struct { char id[9]; int key; long verified; int hide_verify; double t; int nplayers; int players[2]; int in_feed; } Run;
+
+static Game games[MAX_GAMES];
+static int ngames;
+static Player players[MAX_PLAYERS];
+static int nplayers;
+static Key *keys;
+static int nkeys, capkeys;
+static Run *runs;
+static int nruns, capruns;
+static const char *g_out;
+static FILE *g_index;
+
+/* ---- deterministic helpers ---- */
+
+static uint64_t g_rng = 1;
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rnd(void) { return splitmix64(&g_rng); }
+static int rnd_int(int n) { return (int)(rnd() % (uint64_t)n); }
+static double rnd_unit(void) { return (double)(rnd() >> 11) / 9007199254740992.0; }
+
+static void make_id(char out[9]) {
+    static const char alphabet[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    uint64_t v = rnd();
+    for (int i = 0; i < 8; i++) { out[i] = alphabet[v % 36]; v /= 36; }
+    out[8] = '\0';
+}
+
+static uint64_t fnv1a_64(const char *s) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char*)s; *p; p++) {
+        h ^= (uint64_t)(*p);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void iso_utc(long epoch, char *out, size_t outsz) {
+    time_t t = (time_t)epoch;
+    struct tm tmv;
+    gmtime_r(&t, &tmv);
+    strftime(out, outsz, "%Y-%m-%dT%H:%M:%SZ", &tmv);
+}
+
+static FILE *open_response(const char *url) {
+    char path[1024];
+    unsigned long long h = (unsigned long long)fnv1a_64(url);
+    snprintf(path, sizeof(path), "%s/%016llx.json", g_out, h);
+    FILE *f = fopen(path, "wb");
+    if (!f) { perror(path); exit(1); }
+    fprintf(g_index, "%016llx\t%s\n", h, url);
+    return f;
+}
+
+/* ---- world ---- */
+
+static const char *words_a[] = {
+    "Super", "Dark", "Crystal", "Neon", "Lost", "Iron", "Pixel", "Hollow", "Star", "Midnight",
+    "Wild", "Tiny", "Royal", "Frozen", "Rocket", "Shadow", "Golden", "Turbo", "Silent", "Cosmic"
+};
+static const char *words_b[] = {
+    "Quest", "Kart", "Kingdom", "Odyssey", "Runner", "Tactics", "Legends", "Garden", "Empire", "Drift",
+    "Dungeon", "Island", "Circuit", "Saga", "Frontier", "Arcade", "Tower", "Heist", "Voyage", "Rally"
+};
+static const char *suffixes[] = {
+    "", "", "", " 2", " HD", " Remake", ": Director's Cut", " & Friends", " <Deluxe>", " | Extensions"
+};
+static const char *cat_names[] = {
+    "Any%", "100%", "Low%", "Glitchless", "All Bosses", "Time Trial", "Co-op", "Any% No Major Glitches"
+};
+static const char *var_names[] = { "Platform", "Difficulty", "Version", "Players", "Character", "Region" };
+static const char *var_labels[] = {
+    "PC", "Console", "Easy", "Hard", "1.0.0", "1.2 (Latest)", "1 Player", "2 Players",
+    "Knight", "Mage", "NTSC", "PAL", "Emulator", "Critical/Level 1"
+};
+static const char *syllables[] = {
+    "ka", "zo", "mi", "ra", "te", "lun", "vex", "shi", "dor", "pa", "qu", "xen", "bo", "ly", "fe", "nor"
+};
+
+static void gen_world(int flood_levels) {
+    ngames = MAX_GAMES;
+    for (int g = 0; g < ngames; g++) {
+        Game *gm = &games[g];
+        make_id(gm->id);
+        snprintf(gm->name, sizeof(gm->name), "%s %s%s",
+                 words_a[rnd_int(20)], words_b[rnd_int(20)], suffixes[rnd_int(10)]);
+        snprintf(gm->abbr, sizeof(gm->abbr), "g%.7s", gm->id);
+        snprintf(gm->cover_v, sizeof(gm->cover_v), "%07llx", (unsigned long long)(rnd() & 0xfffffffULL));
+
+        gm->nlevels = (g == 0) ? flood_levels : (rnd_int(5) == 0 ? 2 + rnd_int(MAX_LEVELS - 2) : 0);
+        for (int l = 0; l < gm->nlevels; l++) {
+            make_id(gm->levels[l].id);
+            snprintf(gm->levels[l].name, sizeof(gm->levels[l].name), "%s %s %d",
+                     words_a[rnd_int(20)], words_b[rnd_int(20)], l + 1);
+        }
+
+        gm->ncats = 1 + rnd_int(MAX_CATS);
+        for (int c = 0; c < gm->ncats; c++) {
+            Cat *ct = &gm->cats[c];
+            make_id(ct->id);
+            snprintf(ct->name, sizeof(ct->name), "%s", cat_names[rnd_int(8)]);
+            ct->is_il = gm->nlevels > 0 && (c == 0 || rnd_int(2) == 0);
+            ct->nvars = rnd_int(MAX_VARS + 1);
+            for (int v = 0; v < ct->nvars; v++) {
+                Var *vr = &ct->vars[v];
+                make_id(vr->id);
+                snprintf(vr->name, sizeof(vr->name), "%s", var_names[rnd_int(6)]);
+                vr->nvals = 2 + rnd_int(MAX_VALS - 1);
+                for (int k = 0; k < vr->nvals; k++) {
+                    make_id(vr->val_id[k]);
+                    snprintf(vr->val_label[k], sizeof(vr->val_label[k]), "%s", var_labels[rnd_int(14)]);
+                }
+            }
+        }
+    }
+
+    nplayers = MAX_PLAYERS;
+    for (int p = 0; p < nplayers; p++) {
+        Player *pl = &players[p];
+        make_id(pl->id);
+        int n = 2 + rnd_int(3);
+        pl->name[0] = '\0';
+        for (int i = 0; i < n; i++) strcat(pl->name, syllables[rnd_int(16)]);
+        if (rnd_int(4) == 0) {
+            char num[8];
+            snprintf(num, sizeof(num), "%d", rnd_int(100));
+            strcat(pl->name, num);
+        }
+        pl->guest = rnd_int(8) == 0;
+        pl->has_image = !pl->guest && rnd_int(3) != 0;
+        snprintf(pl->img_v, sizeof(pl->img_v), "%07llx", (unsigned long long)(rnd() & 0xfffffffULL));
+    }
+}
+
+static int add_run(void) {
+    if (nruns == capruns) {
+        capruns = capruns ? capruns * 2 : 4096;
+        runs = realloc(runs, (size_t)capruns * sizeof(Run));
+        if (!runs) { perror("realloc"); exit(1); }
+    }
+    Run *r = &runs[nruns];
+    memset(r, 0, sizeof(*r));
+    make_id(r->id);
+    r->nplayers = 1;
+    r->players[0] = rnd_int(nplayers);
+    return nruns++;
+}
+
+static void key_add_run(Key *k, int run) {
+    k->runs = realloc(k->runs, (size_t)(k->nruns + 1) * sizeof(int));
+    if (!k->runs) { perror("realloc"); exit(1); }
+    k->runs[k->nruns++] = run;
+}
+
+static int find_or_add_key(int g, int c, int l, const int *val, long now) {
+    int nv = games[g].cats[c].nvars;
+    for (int i = 0; i < nkeys; i++) {
+        Key *k = &keys[i];
+        if (k->game != g || k->cat != c || k->level != l) continue;
+        int same = 1;
+        for (int v = 0; v < nv; v++) if (k->val[v] != val[v]) same = 0;
+        if (same) return i;
+    }
+
+    if (nkeys == capkeys) {
+        capkeys = capkeys ? capkeys * 2 : 1024;
+        keys = realloc(keys, (size_t)capkeys * sizeof(Key));
+        if (!keys) { perror("realloc"); exit(1); }
+    }
+    Key *k = &keys[nkeys];
+    memset(k, 0, sizeof(*k));
+    k->game = g; k->cat = c; k->level = l;
+    for (int v = 0; v < nv; v++) k->val[v] = val[v];
+
+    /* leaderboard history: older runs, a few without a verify-date */
+    double base = 30.0 + rnd_unit() * 3600.0;
+    int hist = 1 + rnd_int(rnd_int(4) == 0 ? 240 : 40);
+    k->best = INFINITY;
+    for (int i = 0; i < hist; i++) {
+        int r = add_run();
+        Run *run = &runs[r];
+        run->key = nkeys;
+        run->t = base * (1.0 + rnd_unit() * 0.6);
+        run->verified = now - 2 * 86400 - (long)(rnd_unit() * 400.0 * 86400.0);
+        run->hide_verify = rnd_int(25) == 0;
+        if (run->t < k->best) k->best = run->t;
+        key_add_run(k, r);
+    }
+    return nkeys++;
+}
+
+static int cmp_run_verified_asc(const void *a, const void *b) {
+    const Run *ra = &runs[*(const int*)a];
+    const Run *rb = &runs[*(const int*)b];
+    return (ra->verified > rb->verified) - (ra->verified < rb->verified);
+}
+
+static int cmp_run_verified_desc(const void *a, const void *b) {
+    return cmp_run_verified_asc(b, a);
+}
+
+static int cmp_run_time_asc(const void *a, const void *b) {
+    const Run *ra = &runs[*(const int*)a];
+    const Run *rb = &runs[*(const int*)b];
+    if (ra->t < rb->t) return -1;
+    if (ra->t > rb->t) return 1;
+    return (ra->verified > rb->verified) - (ra->verified < rb->verified);
+}
+
+/* ---- JSON emitters ---- */
+
+static void emit_players(FILE *f, const Run *r, int embed) {
+    fputs("[", f);
+    for (int i = 0; i < r->nplayers; i++) {
+        const Player *p = &players[r->players[i]];
+        if (i) fputs(",", f);
+        if (p->guest) {
+            fprintf(f, "{\"rel\":\"guest\",\"name\":\"%s\",\"uri\":\"" API "/guests/%s\"}", p->name, p->name);
+        } else if (!embed) {
+            fprintf(f, "{\"rel\":\"user\",\"id\":\"%s\",\"uri\":\"" API "/users/%s\"}", p->id, p->id);
+        } else {
+            fprintf(f, "{\"rel\":\"user\",\"id\":\"%s\",\"names\":{\"international\":\"%s\",\"japanese\":null},"
+                       "\"weblink\":\"https://www.speedrun.com/users/%s\",\"name-style\":{\"style\":\"solid\"},"
+                       "\"role\":\"user\",\"assets\":{\"icon\":{\"uri\":null},",
+                    p->id, p->name, p->name);
+            if (p->has_image) {
+                fprintf(f, "\"image\":{\"uri\":\"http://www.speedrun.com/static/user/%s/image?v=%s\"}}}", p->id, p->img_v);
+            } else {
+                fputs("\"image\":{\"uri\":null}}}", f);
+            }
+        }
+    }
+    fputs("]", f);
+}
+
+static void emit_values(FILE *f, const Key *k) {
+    const Cat *c = &games[k->game].cats[k->cat];
+    fputs("{", f);
+    for (int v = 0; v < c->nvars; v++) {
+        fprintf(f, "%s\"%s\":\"%s\"", v ? "," : "", c->vars[v].id, c->vars[v].val_id[k->val[v]]);
+    }
+    fputs("}", f);
+}
+
+static void emit_status(FILE *f, const Run *r, int with_verify) {
+    if (with_verify) {
+        char iso[32];
+        iso_utc(r->verified, iso, sizeof(iso));
+        fprintf(f, "{\"status\":\"verified\",\"examiner\":\"x7mod001\",\"verify-date\":\"%s\"}", iso);
+    } else {
+        fputs("{\"status\":\"verified\",\"examiner\":\"x7mod001\",\"verify-date\":null}", f);
+    }
+}
+
+/* A run object; embed=1 matches ?embed=game,category,players,level */
+static void emit_run(FILE *f, const Run *r, int embed, int with_verify) {
+    const Key *k = &keys[r->key];
+    const Game *g = &games[k->game];
+    const Cat *c = &g->cats[k->cat];
+    char date[32];
+    iso_utc(r->verified - 86400, date, sizeof(date));
+
+    fprintf(f, "{\"id\":\"%s\",\"weblink\":\"https://www.speedrun.com/%s/runs/%s\",", r->id, g->abbr, r->id);
+    if (embed) {
+        fprintf(f, "\"game\":{\"data\":{\"id\":\"%s\",\"names\":{\"international\":\"%s\",\"japanese\":null,\"twitch\":\"%s\"},"
+                   "\"abbreviation\":\"%s\",\"weblink\":\"https://www.speedrun.com/%s\",\"released\":2019,"
+                   "\"assets\":{\"logo\":{\"uri\":null},"
+                   "\"cover-tiny\":{\"uri\":\"http://www.speedrun.com/static/game/%s/cover?v=%s\",\"width\":32,\"height\":45},"
+                   "\"cover-small\":{\"uri\":\"https://www.speedrun.com/static/game/%s/cover?v=%s\",\"width\":64,\"height\":90},"
+                   "\"icon\":{\"uri\":\"https://www.speedrun.com/static/game/%s/icon?v=%s\",\"width\":64,\"height\":64}}}},",
+                g->id, g->name, g->name, g->abbr, g->abbr, g->id, g->cover_v, g->id, g->cover_v, g->id, g->cover_v);
+        if (k->level >= 0) {
+            fprintf(f, "\"level\":{\"data\":{\"id\":\"%s\",\"name\":\"%s\",\"weblink\":\"https://www.speedrun.com/%s\"}},",
+                    g->levels[k->level].id, g->levels[k->level].name, g->abbr);
+        } else {
+            fputs("\"level\":{\"data\":[]},", f);
+        }
+        fprintf(f, "\"category\":{\"data\":{\"id\":\"%s\",\"name\":\"%s\",\"type\":\"%s\",\"rules\":\"Timing starts on first input.\"}},",
+                c->id, c->name, c->is_il ? "per-level" : "per-game");
+    } else {
+        fprintf(f, "\"game\":\"%s\",", g->id);
+        if (k->level >= 0) fprintf(f, "\"level\":\"%s\",", g->levels[k->level].id);
+        else fputs("\"level\":null,", f);
+        fprintf(f, "\"category\":\"%s\",", c->id);
+    }
+    fprintf(f, "\"videos\":{\"links\":[{\"uri\":\"https://www.youtube.com/watch?v=%s\"}]},"
+               "\"comment\":\"GG \\\"clean\\\" run\",\"status\":", r->id);
+    emit_status(f, r, with_verify);
+    fputs(",\"players\":", f);
+    if (embed) { fputs("{\"data\":", f); emit_players(f, r, 1); fputs("}", f); }
+    else emit_players(f, r, 0);
+    fprintf(f, ",\"date\":\"%.10s\",\"submitted\":\"%s\","
+               "\"times\":{\"primary\":\"PT%.3fS\",\"primary_t\":%.3f,\"realtime\":\"PT%.3fS\",\"realtime_t\":%.3f,"
+               "\"realtime_noloads\":null,\"realtime_noloads_t\":0,\"ingame\":null,\"ingame_t\":0},"
+               "\"system\":{\"platform\":\"8gej2n93\",\"emulated\":false,\"region\":null},\"splits\":null,\"values\":",
+            date, date, r->t, r->t, r->t, r->t);
+    emit_values(f, k);
+    fprintf(f, ",\"links\":[{\"rel\":\"self\",\"uri\":\"" API "/runs/%s\"}]}", r->id);
+}
+
+/* Same URL shape as wr_daily's build_leaderboard_url_top() */
+static void leaderboard_url(const Key *k, int top, char *out, size_t outsz) {
+    const Game *g = &games[k->game];
+    const Cat *c = &g->cats[k->cat];
+    int n;
+    if (k->level >= 0) {
+        n = snprintf(out, outsz, API "/leaderboards/%s/level/%s/%s?top=%d", g->id, g->levels[k->level].id, c->id, top);
+    } else {
+        n = snprintf(out, outsz, API "/leaderboards/%s/category/%s?top=%d", g->id, c->id, top);
+    }
+    for (int v = 0; v < c->nvars && n > 0 && (size_t)n < outsz; v++) {
+        n += snprintf(out + n, outsz - (size_t)n, "&var-%s=%s", c->vars[v].id, c->vars[v].val_id[k->val[v]]);
+    }
+}
+
+static void emit_leaderboard(const Key *k, int top) {
+    char url[2048];
+    leaderboard_url(k, top, url, sizeof(url));
+    FILE *f = open_response(url);
+
+    const Game *g = &games[k->game];
+    const Cat *c = &g->cats[k->cat];
+    fprintf(f, "{\"data\":{\"weblink\":\"https://www.speedrun.com/%s\",\"game\":\"%s\",\"category\":\"%s\",",
+            g->abbr, g->id, c->id);
+    if (k->level >= 0) fprintf(f, "\"level\":\"%s\",", g->levels[k->level].id);
+    else fputs("\"level\":null,", f);
+    fputs("\"platform\":null,\"region\":null,\"emulators\":null,\"video-only\":false,\"timing\":\"realtime\",\"values\":", f);
+    emit_values(f, k);
+    fputs(",\"runs\":[", f);
+    int n = k->nruns < top ? k->nruns : top;
+    for (int i = 0; i < n; i++) {
+        const Run *r = &runs[k->runs[i]];
+        fprintf(f, "%s{\"place\":%d,\"run\":", i ? "," : "", i + 1);
+        emit_run(f, r, 0, !r->hide_verify);
+        fputs("}", f);
+    }
+    fputs("],\"links\":[]}}", f);
+    fclose(f);
+}
+
+static void emit_run_details(const Run *r, int embed) {
+    char url[512];
+    if (embed) snprintf(url, sizeof(url), API "/runs/%s?embed=game,category,players,level", r->id);
+    else snprintf(url, sizeof(url), API "/runs/%s", r->id);
+    FILE *f = open_response(url);
+    fputs("{\"data\":", f);
+    emit_run(f, r, embed, 1);
+    fputs("}", f);
+    fclose(f);
+}
+
+static void emit_category_vars(const Game *g, const Cat *c) {
+    char url[512];
+    snprintf(url, sizeof(url), API "/categories/%s/variables?max=200", c->id);
+    FILE *f = open_response(url);
+    fputs("{\"data\":[", f);
+    for (int v = 0; v < c->nvars; v++) {
+        const Var *vr = &c->vars[v];
+        fprintf(f, "%s{\"id\":\"%s\",\"name\":\"%s\",\"category\":\"%s\",\"scope\":{\"type\":\"%s\"},"
+                   "\"mandatory\":true,\"user-defined\":false,\"obsoletes\":true,\"values\":{\"values\":{",
+                v ? "," : "", vr->id, vr->name, c->id, g->nlevels ? "global" : "full-game");
+        for (int k = 0; k < vr->nvals; k++) {
+            fprintf(f, "%s\"%s\":{\"label\":\"%s\",\"rules\":null,\"flags\":{\"miscellaneous\":false}}",
+                    k ? "," : "", vr->val_id[k], vr->val_label[k]);
+        }
+        fprintf(f, "},\"default\":\"%s\"},\"is-subcategory\":true,\"links\":[]}", vr->val_id[0]);
+    }
+    fputs("]}", f);
+    fclose(f);
+}
+
+/* /games/{id}/records?top=1&scope=all&skip-empty=true: the unfiltered top run of each board */
+static void emit_game_records(const Game *gm) {
+    int g = (int)(gm - games);
+    char url[512];
+    snprintf(url, sizeof(url), API "/games/%.*s/records?top=1&scope=all&skip-empty=true&max=%d&offset=0",
+             (int)sizeof(gm->id), gm->id, PAGE);
+    FILE *f = open_response(url);
+    fputs("{\"data\":[", f);
+    int n = 0;
+    for (int c = 0; c < gm->ncats; c++) {
+        const Cat *cat = &gm->cats[c];
+        for (int l = cat->is_il ? 0 : -1; l < (cat->is_il ? gm->nlevels : 0); l++) {
+            int best = -1;
+            for (int i = 0; i < nkeys; i++) {
+                const Key *k = &keys[i];
+                if (k->game != g || k->cat != c || k->level != l || k->nruns == 0) continue;
+                if (best < 0 || cmp_run_time_asc(&k->runs[0], &best) < 0) best = k->runs[0];
+            }
+            if (best < 0) continue;
+            const Run *top = &runs[best];
+            fprintf(f, "%s{\"weblink\":\"https://www.speedrun.com/%s\",\"game\":\"%s\",\"category\":\"%s\",",
+                    n++ ? "," : "", gm->abbr, gm->id, cat->id);
+            if (l >= 0) fprintf(f, "\"level\":\"%s\",", gm->levels[l].id);
+            else fputs("\"level\":null,", f);
+            fputs("\"platform\":null,\"region\":null,\"emulators\":null,\"video-only\":false,\"timing\":\"realtime\","
+                  "\"values\":{},\"runs\":[{\"place\":1,\"run\":", f);
+            emit_run(f, top, 0, !top->hide_verify);
+            fputs("}],\"links\":[]}", f);
+        }
+    }
+    fprintf(f, "],\"pagination\":{\"offset\":0,\"max\":%d,\"size\":%d,\"links\":[]}}", PAGE, n);
+    fclose(f);
+}
+
+/* One /runs page at offset off, holding the feed from index first on. */
+static int emit_feed_page(const int *feed, int nfeed, int off, int first) {
+    char url[512];
+    snprintf(url, sizeof(url),
+             API "/runs?status=verified&orderby=verify-date&direction=desc"
+             "&embed=game,category,players,level&max=%d&offset=%d", PAGE, off);
+    FILE *f = open_response(url);
+    int n = nfeed - first;
+    if (n < 0) n = 0;
+    if (n > PAGE) n = PAGE;
+    fputs("{\"data\":[", f);
+    for (int i = 0; i < n; i++) {
+        if (i) fputs(",", f);
+        emit_run(f, &runs[feed[first + i]], 1, 1);
+    }
+    fprintf(f, "],\"pagination\":{\"offset\":%d,\"max\":%d,\"size\":%d,\"links\":[]}}", off, PAGE, n);
+    fclose(f);
+    return n;
+}
+
+/*
+   Pages at the offsets wr_daily walks (PAGE - OVERLAP apart) and at plain multiples
+   of PAGE. drift > 0 models runs verified while the walk is under way: page i of
+   the walk is pushed down by i * drift runs; drift < 0 pulls it up instead, as if
+   runs already read had been un-verified. Once wr_daily has measured a push it
+   requests each later page that much further down, so those offsets move with it.
+*/
+static void emit_feed(const int *feed, int nfeed, int drift) {
+    int ahead = drift > 0 ? drift : 0;
+    for (int i = 0, off = 0; off <= nfeed; i++, off += PAGE - OVERLAP + (i > 1 ? ahead : 0)) {
+        int first = off - i * drift;
+        if (first < 0) first = 0;
+        if (emit_feed_page(feed, nfeed, off, first) < PAGE) break;
+    }
+    for (int off = PAGE; ; off += PAGE) {
+        if (off % (PAGE - OVERLAP) == 0) continue;
+        if (emit_feed_page(feed, nfeed, off, off) < PAGE) break;
+    }
+}
+
+int main(int argc, char **argv) {
+    long now = 0;
+    int nfeed_target = 1200;
+    int drift = 0;
+    g_out = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) g_out = argv[++i];
+        else if (strcmp(argv[i], "--now") == 0 && i + 1 < argc) now = strtol(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) nfeed_target = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) g_rng = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--feed-drift") == 0 && i + 1 < argc) drift = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: gen_replay --out DIR --now EPOCH [--runs N] [--seed S] [--feed-drift N]\n");
+            return 2;
+        }
+    }
+    if (!g_out || now <= 0 || nfeed_target <= 0) {
+        fprintf(stderr, "usage: gen_replay --out DIR --now EPOCH [--runs N] [--seed S] [--feed-drift N]\n");
+        return 2;
+    }
+
+    if (mkdir(g_out, 0755) != 0) {
+        struct stat st;
+        if (stat(g_out, &st) != 0 || !S_ISDIR(st.st_mode)) { perror(g_out); return 1; }
+    }
+    char idx[1024];
+    snprintf(idx, sizeof(idx), "%s/index.tsv", g_out);
+    g_index = fopen(idx, "wb");
+    if (!g_index) { perror(idx); return 1; }
+
+    gen_world(MAX_LEVELS);
+
+    /* feed runs: ~26h window so the cold-start scan (24h + 1h overlap) hits its floor */
+    int *feed = calloc((size_t)nfeed_target, sizeof(int));
+    if (!feed) { perror("calloc"); return 1; }
+    for (int i = 0; i < nfeed_target; i++) {
+        int g = rnd_int(10) == 0 ? 0 : rnd_int(ngames);
+        const Game *gm = &games[g];
+        int c = rnd_int(gm->ncats);
+        int l = gm->cats[c].is_il ? rnd_int(gm->nlevels) : -1;
+        int val[MAX_VARS] = {0};
+        for (int v = 0; v < gm->cats[c].nvars; v++) val[v] = rnd_int(gm->cats[c].vars[v].nvals);
+
+        int k = find_or_add_key(g, c, l, val, now);
+        int r = add_run();
+        Run *run = &runs[r];
+        run->key = k;
+        run->in_feed = 1;
+        run->verified = now - 30 - (long)(rnd_unit() * 26.0 * 3600.0);
+        if (rnd_int(6) == 0) { run->nplayers = 2; run->players[1] = rnd_int(nplayers); }
+        key_add_run(&keys[k], r);
+        feed[i] = r;
+    }
+
+    /* times in verification order: ~40% improve the record, the rest don't */
+    qsort(feed, (size_t)nfeed_target, sizeof(int), cmp_run_verified_asc);
+    for (int i = 0; i < nfeed_target; i++) {
+        Run *run = &runs[feed[i]];
+        Key *k = &keys[run->key];
+        if (rnd_int(10) < 4) {
+            run->t = k->best * (0.97 + rnd_unit() * 0.029);
+            k->best = run->t;
+        } else {
+            run->t = k->best * (1.0 + rnd_unit() * 0.3) + 0.5;
+        }
+    }
+
+    for (int i = 0; i < nkeys; i++) {
+        Key *k = &keys[i];
+        qsort(k->runs, (size_t)k->nruns, sizeof(int), cmp_run_time_asc);
+        emit_leaderboard(k, 1);
+        emit_leaderboard(k, TOPN);
+    }
+
+    for (int g = 0; g < ngames; g++) {
+        for (int c = 0; c < games[g].ncats; c++) emit_category_vars(&games[g], &games[g].cats[c]);
+    }
+
+    for (int i = 0; i < nruns; i++) {
+        if (runs[i].in_feed) emit_run_details(&runs[i], 1);
+        else if (runs[i].hide_verify) emit_run_details(&runs[i], 0);
+    }
+
+    qsort(feed, (size_t)nfeed_target, sizeof(int), cmp_run_verified_desc);
+    emit_feed(feed, nfeed_target, drift);
+    for (int g = 0; g < ngames; g++) emit_game_records(&games[g]);
+
+    fclose(g_index);
+    fprintf(stderr, "gen_replay: %d feed runs, %d leaderboard keys, %d runs total -> %s\n",
+            nfeed_target, nkeys, nruns, g_out);
+
+    for (int i = 0; i < nkeys; i++) free(keys[i].runs);
+    free(keys);
+    free(runs);
+    free(feed);
+    return 0;
+}
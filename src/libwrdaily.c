@@ -0,0 +1,7337 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <math.h>
+#include <dirent.h>
+#include <pthread.h>
+
+#include <curl/curl.h>
+#include <cjson/cJSON.h>
+
+#define WRD_BUILD
+#include "wrdaily.h"
+
+typedef struct { char *data; size_t size; } Buffer;
+
+/* ----------------- debug / logging ----------------- */
+
+static int g_debug = 1; // set DEBUG=0 in env to silence
+
+static void log_ts(FILE *fp) {
+    time_t t = time(NULL);
+    struct tm tmv;
+    gmtime_r(&t, &tmv);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tmv);
+    fprintf(fp, "%sZ ", buf);
+}
+
+#define LOG(fmt, ...) do { \
+    if (g_debug) { \
+        flockfile(stderr); \
+        log_ts(stderr); \
+        fprintf(stderr, "[dbg] " fmt "\n", ##__VA_ARGS__); \
+        fflush(stderr); \
+        funlockfile(stderr); \
+    } \
+} while (0)
+
+static void init_debug_from_env(void) {
+    const char *v = getenv("DEBUG");
+    if (!v) return;
+    if (strcmp(v, "0") == 0 || strcasecmp(v, "false") == 0 || strcasecmp(v, "no") == 0) g_debug = 0;
+}
+
+/* ----------------- USDT probes ----------------- */
+
+/*
+   Static tracepoints for bpftrace/perf (provider "wr_daily"); see tools/bpftrace/.
+   Built in when sys/sdt.h is available (the Makefile sets WR_USDT). The probe site is
+   a nop until a tracer attaches, but its arguments are still evaluated on every
+   pass, so they must be cheap and side-effect free.
+*/
+#if defined(WR_USDT)
+#include <sys/sdt.h>
+#define WR_PROBE(name, ...) STAP_PROBEV(wr_daily, name, ##__VA_ARGS__)
+#else
+#define WR_PROBE(name, ...) do { } while (0)
+#endif
+
+static inline long elapsed_us_since(const struct timespec *t0) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (long)(t1.tv_sec - t0->tv_sec) * 1000000L + (long)(t1.tv_nsec - t0->tv_nsec) / 1000L;
+}
+
+/* ----------------- http helpers ----------------- */
+
+static char *read_file(const char *path);
+static int write_file(const char *path, const char *data);
+static uint64_t fnv1a_64(const char *s);
+static int buf_append(Buffer *b, const char *s, size_t n);
+
+/*
+   Offline replay / recording of API responses.
+   --record=DIR stores every successful response as DIR/<fnv1a_64(url)>.json and
+   appends "<hash>\t<url>" to DIR/index.tsv; --replay=DIR serves requests from such
+   a directory instead of the network (a missing file behaves like an HTTP 404).
+   Replay also skips the politeness sleeps so runs are pure CPU.
+*/
+static const char *g_replay_dir = NULL;
+static const char *g_record_dir = NULL;
+
+/* --api=BASE sends API requests to BASE (e.g. a `wr_daily proxy`) instead of API_ORIGIN;
+   logs, records and replays keep using the canonical URL. */
+#define API_ORIGIN "https://www.speedrun.com"
+static const char *g_api_base = NULL;
+
+static void replay_file_path(const char *dir, const char *url, char *out, size_t outsz) {
+    snprintf(out, outsz, "%s/%016llx.json", dir, (unsigned long long)fnv1a_64(url));
+}
+
+static char *replay_fetch(const char *url) {
+    char path[1024];
+    replay_file_path(g_replay_dir, url, path, sizeof(path));
+    char *body = read_file(path);
+    if (!body) LOG("REPLAY miss (404): %s", url);
+    return body;
+}
+
+static void record_response(const char *url, const char *body) {
+    char path[1024];
+    replay_file_path(g_record_dir, url, path, sizeof(path));
+    if (!write_file(path, body)) return;
+
+    char idx[1024];
+    snprintf(idx, sizeof(idx), "%s/index.tsv", g_record_dir);
+    FILE *f = fopen(idx, "ab");
+    if (!f) return;
+    /* one write per line: appends from several workers must not interleave */
+    char line[4200];
+    int n = snprintf(line, sizeof(line), "%016llx\t%s\n", (unsigned long long)fnv1a_64(url), url);
+    if (n > 0) fwrite(line, 1, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1, f);
+    fclose(f);
+}
+
+/*
+   Fault injection on top of --replay (--faults=PROFILE[,key=value...]). Each
+   attempt of fetch_url() draws from a seeded generator: a latency sample
+   (log-normal around median_ms), and possibly a 429 storm (storm consecutive
+   attempts answered 429 with Retry-After), a 5xx burst, a truncated 200 body or a
+   timeout. Latency, back-off and politeness sleeps are charged to a virtual clock
+   (g_tx.sim_wait_ms) instead of being slept, so a degraded run costs CPU time only
+   and its end-to-end time is wall time + sim_wait_ms.
+*/
+typedef struct {
+    const char *name;
+    double median_ms, sigma;    /* per-attempt latency */
+    double p429; int storm_len; int retry_after_s;
+    double p5xx; int burst_max;
+    double ptrunc, ptimeout;
+} FaultProfile;
+
+static const FaultProfile k_fault_profiles[] = {
+    { "clean",     120, 0.3, 0,    0,  0, 0,    0, 0,    0     },
+    { "slow",      900, 0.8, 0,    0,  0, 0,    0, 0,    0     },
+    { "throttle",  150, 0.3, 0.02, 15, 2, 0,    0, 0,    0     },
+    { "flaky5xx",  150, 0.3, 0,    0,  0, 0.03, 4, 0,    0     },
+    { "truncated", 150, 0.3, 0,    0,  0, 0,    0, 0.03, 0     },
+    { "timeouts",  150, 0.3, 0,    0,  0, 0,    0, 0,    0.01  },
+    { "degraded",  400, 0.7, 0.01, 10, 1, 0.02, 3, 0.01, 0.005 },
+};
+
+typedef struct {
+    long requests, attempts, ok, failed, retries;
+    long inj_429, inj_5xx, inj_trunc, inj_timeout;
+    double sim_wait_ms;
+} TransportStats;
+
+static FaultProfile g_faults;
+static int g_faults_on = 0;
+static uint64_t g_fault_rng = 0x9e3779b97f4a7c15ULL;
+static int g_fault_storm_left = 0, g_fault_burst_left = 0;
+static TransportStats g_tx;
+/* g_tx and the fault generator: fetch_url() runs on --jobs check workers too */
+static pthread_mutex_t g_tx_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void tx_count(long *counter) {
+    pthread_mutex_lock(&g_tx_lock);
+    (*counter)++;
+    pthread_mutex_unlock(&g_tx_lock);
+}
+
+static long tx_read(const long *counter) {
+    pthread_mutex_lock(&g_tx_lock);
+    long v = *counter;
+    pthread_mutex_unlock(&g_tx_lock);
+    return v;
+}
+
+static void tx_sim_wait(double ms) {
+    pthread_mutex_lock(&g_tx_lock);
+    g_tx.sim_wait_ms += ms;
+    pthread_mutex_unlock(&g_tx_lock);
+}
+
+static uint64_t fault_next(void) {
+    /* xorshift64* */
+    g_fault_rng ^= g_fault_rng >> 12;
+    g_fault_rng ^= g_fault_rng << 25;
+    g_fault_rng ^= g_fault_rng >> 27;
+    return g_fault_rng * 0x2545F4914F6CDD1DULL;
+}
+
+static double fault_uniform(void) {
+    return (double)(fault_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* "throttle" or "degraded,p429=0.05,seed=7"; 0 on an unknown name/key */
+static int faults_parse(const char *spec) {
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s", spec);
+    char *save = NULL;
+    char *name = strtok_r(tmp, ",", &save);
+    int found = 0;
+    for (size_t i = 0; name && i < sizeof(k_fault_profiles) / sizeof(k_fault_profiles[0]); i++) {
+        if (strcmp(name, k_fault_profiles[i].name) == 0) { g_faults = k_fault_profiles[i]; found = 1; }
+    }
+    if (!found) return 0;
+
+    for (char *kv = strtok_r(NULL, ",", &save); kv; kv = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(kv, '=');
+        if (!eq) return 0;
+        *eq++ = '\0';
+        double v = atof(eq);
+        if (strcmp(kv, "median_ms") == 0) g_faults.median_ms = v;
+        else if (strcmp(kv, "sigma") == 0) g_faults.sigma = v;
+        else if (strcmp(kv, "p429") == 0) g_faults.p429 = v;
+        else if (strcmp(kv, "storm") == 0) g_faults.storm_len = (int)v;
+        else if (strcmp(kv, "retry_after") == 0) g_faults.retry_after_s = (int)v;
+        else if (strcmp(kv, "p5xx") == 0) g_faults.p5xx = v;
+        else if (strcmp(kv, "burst") == 0) g_faults.burst_max = (int)v;
+        else if (strcmp(kv, "ptrunc") == 0) g_faults.ptrunc = v;
+        else if (strcmp(kv, "ptimeout") == 0) g_faults.ptimeout = v;
+        else if (strcmp(kv, "seed") == 0) g_fault_rng = (uint64_t)strtoull(eq, NULL, 10) * 0x9e3779b97f4a7c15ULL + 1;
+        else return 0;
+    }
+    g_faults_on = 1;
+    return 1;
+}
+
+/* The injected outcome of one attempt (caller holds g_tx_lock); *http_code 0 if none. */
+static CURLcode fault_decide(long *http_code, long *retry_after) {
+    double u1 = fault_uniform(), u2 = fault_uniform();
+    double z = sqrt(-2.0 * log(u1 > 0 ? u1 : 1e-12)) * cos(2.0 * M_PI * u2);
+    g_tx.sim_wait_ms += g_faults.median_ms * exp(g_faults.sigma * z);
+
+    if (g_fault_storm_left == 0 && g_faults.p429 > 0 && fault_uniform() < g_faults.p429) {
+        g_fault_storm_left = g_faults.storm_len;
+    }
+    if (g_fault_storm_left > 0) {
+        g_fault_storm_left--;
+        g_tx.inj_429++;
+        *http_code = 429;
+        *retry_after = g_faults.retry_after_s;
+        return CURLE_OK;
+    }
+    if (g_fault_burst_left == 0 && g_faults.p5xx > 0 && fault_uniform() < g_faults.p5xx) {
+        g_fault_burst_left = 1 + (int)(fault_uniform() * g_faults.burst_max);
+    }
+    if (g_fault_burst_left > 0) {
+        g_fault_burst_left--;
+        g_tx.inj_5xx++;
+        *http_code = (fault_next() & 1) ? 502 : 503;
+        return CURLE_OK;
+    }
+    if (g_faults.ptimeout > 0 && fault_uniform() < g_faults.ptimeout) {
+        g_tx.inj_timeout++;
+        g_tx.sim_wait_ms += 60000.0; /* CURLOPT_TIMEOUT */
+        return CURLE_OPERATION_TIMEDOUT;
+    }
+
+    return CURLE_OK; /* *http_code stays 0: serve the replay body */
+}
+
+/*
+   One simulated attempt against the replay dir; fills buf like curl would. Only the
+   draws and the storm/burst state are taken under g_tx_lock: the replay read runs
+   outside it, so --jobs workers still overlap under --faults. With one worker the
+   draw sequence is the same as taking it all at once.
+*/
+static CURLcode fault_perform(const char *url, Buffer *buf, long *http_code, long *retry_after) {
+    pthread_mutex_lock(&g_tx_lock);
+    CURLcode res = fault_decide(http_code, retry_after);
+    pthread_mutex_unlock(&g_tx_lock);
+    if (*http_code != 0 || res != CURLE_OK) return res;
+
+    char *body = replay_fetch(url);
+    if (!body) { *http_code = 404; return CURLE_OK; }
+    size_t n = strlen(body);
+    if (n > 1 && g_faults.ptrunc > 0) {
+        pthread_mutex_lock(&g_tx_lock);
+        if (fault_uniform() < g_faults.ptrunc) {
+            g_tx.inj_trunc++;
+            n = (size_t)(fault_uniform() * (double)(n - 1));
+        }
+        pthread_mutex_unlock(&g_tx_lock);
+    }
+    buf_append(buf, body, n);
+    free(body);
+    *http_code = 200;
+    return CURLE_OK;
+}
+
+static void pace_sleep(useconds_t usec) {
+    if (!g_replay_dir) usleep(usec);
+    else if (g_faults_on) tx_sim_wait((double)usec / 1000.0);
+}
+
+static void backoff_sleep(long usec) {
+    if (!g_replay_dir) usleep((useconds_t)usec);
+    else if (g_faults_on) tx_sim_wait((double)usec / 1000.0);
+}
+
+static size_t write_cb(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    Buffer *buf = (Buffer *)userp;
+
+    char *ptr = realloc(buf->data, buf->size + realsize + 1);
+    if (!ptr) return 0;
+
+    buf->data = ptr;
+    memcpy(buf->data + buf->size, contents, realsize);
+    buf->size += realsize;
+    buf->data[buf->size] = '\0';
+    return realsize;
+}
+
+/*
+   Every API response is one JSON document. Bracket depth, counted outside strings,
+   returns to zero only at its very end, so any body cut short is caught without a
+   full parse.
+*/
+static int body_looks_complete(const Buffer *b) {
+    int depth = 0, in_str = 0, seen = 0;
+    size_t i = 0;
+    for (; i < b->size; i++) {
+        char c = b->data[i];
+        if (in_str) {
+            if (c == '\\') i++;
+            else if (c == '"') in_str = 0;
+            continue;
+        }
+        if (c == '"') in_str = 1;
+        else if (c == '{' || c == '[') { depth++; seen = 1; }
+        else if (c == '}' || c == ']') { if (--depth == 0) { i++; break; } }
+    }
+    if (!seen || depth != 0) return 0;
+    for (; i < b->size; i++) {
+        char c = b->data[i];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') return 0;
+    }
+    return 1;
+}
+
+/*
+   --request-log=FILE: one line per fetch_url() call (after retries), for `wr_daily waste`:
+     caller \t status \t bytes \t attempts \t fnv1a_64(body) \t url
+   preceded by "#run \t now \t pid" once per process. Status is 0 when no response
+   arrived; the body hash lets the report tell a changed response from a repeat.
+*/
+static FILE *g_request_log = NULL;
+
+static void request_log(const char *caller, const char *url, long status, const char *body, int attempts) {
+    if (!g_request_log) return;
+    size_t bytes = body ? strlen(body) : 0;
+    /* one fprintf per line: stdio's lock keeps --jobs workers' lines whole */
+    fprintf(g_request_log, "%s\t%ld\t%zu\t%d\t%016llx\t%s\n", caller, status, bytes, attempts,
+            (unsigned long long)(body ? fnv1a_64(body) : 0), url);
+}
+
+#define fetch_url(curl, url) fetch_url_from((curl), (url), __func__, NULL)
+
+/* The body, or NULL; *status (if given) gets the final HTTP status, 0 if none arrived. */
+static char *fetch_url_from(CURL *curl, const char *url, const char *caller, long *status) {
+    WR_PROBE(http_start, url);
+    tx_count(&g_tx.requests);
+    if (g_replay_dir && !g_faults_on) {
+        char *body = replay_fetch(url);
+        WR_PROBE(http_done, url, body ? 200L : 404L, body ? (long)strlen(body) : 0L, 0L, 1);
+        tx_count(&g_tx.attempts);
+        tx_count(body ? &g_tx.ok : &g_tx.failed);
+        request_log(caller, url, body ? 200 : 404, body, 1);
+        if (status) *status = body ? 200 : 404;
+        return body;
+    }
+
+    Buffer buf = {0};
+    buf.data = malloc(1);
+    buf.size = 0;
+    if (!buf.data) return NULL;
+    buf.data[0] = '\0';
+
+    char routed[4096];
+    const char *target = url;
+    if (g_api_base && strncmp(url, API_ORIGIN "/api/", strlen(API_ORIGIN "/api/")) == 0) {
+        snprintf(routed, sizeof(routed), "%s%s", g_api_base, url + strlen(API_ORIGIN));
+        target = routed;
+    }
+
+    if (!g_replay_dir) {
+        curl_easy_setopt(curl, CURLOPT_URL, target);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&buf);
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, "wr-live-readme-bot/2.1 (libcurl)");
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+        /* h2 over TLS (libcurl's default since 7.62; explicit for older builds) */
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 20L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
+    }
+
+    const int max_attempts = 6;
+    long last_code = 0;
+    int attempt;
+    for (attempt = 0; attempt < max_attempts; attempt++) {
+        buf.size = 0;
+        buf.data[0] = '\0';
+
+        struct timespec w0;
+        clock_gettime(CLOCK_MONOTONIC, &w0);
+        clock_t c0 = clock();
+        long http_code = 0, retry_after = -1;
+        CURLcode res;
+        if (g_replay_dir) {
+            res = fault_perform(url, &buf, &http_code, &retry_after);
+        } else {
+            res = curl_easy_perform(curl);
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+#if LIBCURL_VERSION_NUM >= 0x074200
+            curl_off_t ra = -1;
+            if (curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &ra) == CURLE_OK) retry_after = (long)ra;
+#endif
+        }
+        clock_t c1 = clock();
+        double elapsed = (double)(c1 - c0) / (double)CLOCKS_PER_SEC;
+        tx_count(&g_tx.attempts);
+        last_code = http_code;
+        WR_PROBE(http_done, url, http_code, (long)buf.size, elapsed_us_since(&w0), attempt + 1);
+
+        int ok_status = res == CURLE_OK && http_code >= 200 && http_code < 300;
+        int complete = body_looks_complete(&buf);
+        if (ok_status && complete) {
+            LOG("HTTP %ld in %.2fs (%zu bytes): %s", http_code, elapsed, buf.size, url);
+            if (g_record_dir) record_response(url, buf.data);
+            tx_count(&g_tx.ok);
+            request_log(caller, url, http_code, buf.data, attempt + 1);
+            if (status) *status = http_code;
+            return buf.data;
+        }
+
+        LOG("HTTP FAIL attempt=%d res=%d (%s) code=%ld in %.2fs%s: %s",
+            attempt + 1, (int)res, curl_easy_strerror(res), http_code, elapsed,
+            ok_status ? " (incomplete body)" : "", url);
+
+        /* throttling, server errors, timeouts and cut-off bodies are worth another try */
+        int retryable = http_code == 429 || (http_code >= 500 && http_code < 600) ||
+                        res == CURLE_OPERATION_TIMEDOUT || res == CURLE_PARTIAL_FILE || ok_status;
+        if (!retryable || attempt + 1 == max_attempts) { attempt++; break; }
+
+        tx_count(&g_tx.retries);
+        if (retry_after > 0) backoff_sleep((retry_after > 60 ? 60 : retry_after) * 1000000L);
+        else backoff_sleep(200000L * (attempt + 1));
+    }
+
+    free(buf.data);
+    tx_count(&g_tx.failed);
+    request_log(caller, url, last_code, NULL, attempt);
+    if (status) *status = last_code;
+    return NULL;
+}
+
+/* ----------------- json helpers ----------------- */
+
+static const char *json_get_string(cJSON *obj, const char *key) {
+    cJSON *v = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsString(v) && v->valuestring) return v->valuestring;
+    return NULL;
+}
+
+static double json_get_number(cJSON *obj, const char *key, double fallback) {
+    cJSON *v = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsNumber(v)) return v->valuedouble;
+    return fallback;
+}
+
+static long json_get_long(cJSON *obj, const char *key, long fallback) {
+    cJSON *v = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsNumber(v)) return (long)v->valuedouble;
+    return fallback;
+}
+
+/* ----------------- time helpers ----------------- */
+
+static void format_seconds(double sec, char *out, size_t outsz) {
+    if (sec < 0) { snprintf(out, outsz, "?"); return; }
+    long total = (long)(sec + 0.5);
+    long h = total / 3600;
+    long m = (total % 3600) / 60;
+    long s = total % 60;
+    if (h > 0) snprintf(out, outsz, "%ld:%02ld:%02ld", h, m, s);
+    else snprintf(out, outsz, "%ld:%02ld", m, s);
+}
+
+static time_t parse_iso8601_utc(const char *s) {
+    if (!s) return (time_t)-1;
+
+    char tmp[64];
+    memset(tmp, 0, sizeof(tmp));
+    const char *dot = strchr(s, '.');
+    if (dot) {
+        size_t n = (size_t)(dot - s);
+        if (n >= sizeof(tmp) - 2) return (time_t)-1;
+        memcpy(tmp, s, n);
+        tmp[n] = 'Z';
+        tmp[n+1] = '\0';
+        s = tmp;
+    }
+
+    struct tm tmv;
+    memset(&tmv, 0, sizeof(tmv));
+    if (!strptime(s, "%Y-%m-%dT%H:%M:%SZ", &tmv)) return (time_t)-1;
+    return timegm(&tmv);
+}
+
+/* --- README timestamp formatting in Eastern Time (ET; shows EST/EDT) --- */
+static void init_tz_eastern(void) {
+    setenv("TZ", "America/New_York", 1);
+    tzset();
+}
+
+static void format_pretty_et(time_t t, char *out, size_t outsz) {
+    if (!out || outsz == 0) return;
+    struct tm tmv;
+    localtime_r(&t, &tmv);
+    strftime(out, outsz, "%b %d, %Y %I:%M %p %Z", &tmv);
+}
+
+/* ----------------- batched file I/O (io_uring, plain syscalls as fallback) ----------------- */
+
+/*
+   Two jobs, both optional and invisible to callers of read_file/write_file:
+   - io_prefetch(path) queues a whole-file read at startup; read_file() later takes
+     the buffer (waiting only if it is still in flight), so state and store reads
+     overlap curl/TLS initialisation.
+   - while io_defer_writes(1) is on, write_file() only queues. io_flush_writes()
+     then submits write+fsync pairs for every queued file (and stdout) in one go,
+     waits once, and performs removals that must only happen after the data is on disk.
+     Each file is written to FILE.tmp and renamed over FILE once the whole round is
+     on disk, then the directories are fsynced, so a kill mid-flush leaves every file
+     either old or new, never empty. Files derived from others (io_queue_dependent():
+     --precompress siblings) go in a second round of the same flush, only once every
+     primary file is on disk; write_file_last() files (data/state.json, which says how
+     far the rest got) go in a last round after them.
+   The ring is set up with raw syscalls (no liburing). If io_uring is unavailable
+   (old kernel, seccomp in containers) everything runs as plain read/write/fsync.
+*/
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#define IO_RING_ENTRIES 64
+
+typedef enum { IO_MODE_AUTO, IO_MODE_URING, IO_MODE_SYNC } IoMode;
+
+typedef struct {
+    int fd;
+    unsigned entries;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned queued;   /* SQEs filled since the last io_uring_enter */
+    unsigned inflight; /* CQEs still to come */
+} IoRing;
+
+typedef struct IoOp {
+    char *path;
+    char *tmp;        /* PATH.tmp, renamed over path once the round is on disk */
+    int fd;
+    char *buf;
+    size_t len;
+    int is_read;
+    int do_fsync;
+    int owns_fd;
+    int pending;      /* CQEs outstanding for this op */
+    long res;         /* read/write result */
+    long fsync_res;
+    struct IoOp *next;
+} IoOp;
+
+static IoMode g_io_mode = IO_MODE_AUTO;
+static IoRing g_ring = { .fd = -1 };
+static IoOp *g_io_reads = NULL;
+static IoOp *g_io_writes = NULL;
+static IoOp **g_io_writes_tail = &g_io_writes;
+static IoOp *g_io_dependent = NULL;
+static IoOp **g_io_dependent_tail = &g_io_dependent;
+static IoOp *g_io_last = NULL;
+static IoOp **g_io_last_tail = &g_io_last;
+static int g_io_deferring = 0;
+typedef struct IoUnlink { char *path; struct IoUnlink *next; } IoUnlink;
+static IoUnlink *g_io_unlinks = NULL;
+/* prefetch list + ring: the store loader thread reads while the main thread fetches */
+static pthread_mutex_t g_io_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int io_init(void) {
+    if (g_io_mode == IO_MODE_SYNC) return 1;
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = (int)syscall(__NR_io_uring_setup, IO_RING_ENTRIES, &p);
+    if (fd < 0) {
+        LOG("IO: io_uring unavailable (%s), using plain syscalls", strerror(errno));
+        return g_io_mode != IO_MODE_URING;
+    }
+
+    size_t sq_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    int single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && cq_sz > sq_sz) sq_sz = cq_sz;
+
+    unsigned char *sq = mmap(NULL, sq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    unsigned char *cq = sq;
+    if (sq != MAP_FAILED && !single) {
+        cq = mmap(NULL, cq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    }
+    void *sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+        LOG("IO: io_uring mmap failed, using plain syscalls");
+        close(fd);
+        return g_io_mode != IO_MODE_URING;
+    }
+
+    g_ring.fd = fd;
+    g_ring.entries = p.sq_entries;
+    g_ring.sq_head = (unsigned *)(sq + p.sq_off.head);
+    g_ring.sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    g_ring.sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    g_ring.sq_array = (unsigned *)(sq + p.sq_off.array);
+    g_ring.cq_head = (unsigned *)(cq + p.cq_off.head);
+    g_ring.cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    g_ring.cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    g_ring.cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    g_ring.sqes = (struct io_uring_sqe *)sqes;
+    return 1;
+}
+
+static int io_enter(unsigned min_complete) {
+    unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+    for (;;) {
+        int r = (int)syscall(__NR_io_uring_enter, g_ring.fd, g_ring.queued, min_complete, flags, NULL, 0);
+        if (r >= 0) { g_ring.queued -= (unsigned)r < g_ring.queued ? (unsigned)r : g_ring.queued; return 1; }
+        if (errno != EINTR) return 0;
+    }
+}
+
+static void io_reap(void) {
+    unsigned head = *g_ring.cq_head;
+    unsigned tail = __atomic_load_n(g_ring.cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const struct io_uring_cqe *cqe = &g_ring.cqes[head & *g_ring.cq_mask];
+        /* low bit tags the fsync half of a write+fsync pair */
+        IoOp *op = (IoOp *)(uintptr_t)(cqe->user_data & ~(uint64_t)1);
+        if (cqe->user_data & 1) op->fsync_res = cqe->res;
+        else op->res = cqe->res;
+        op->pending--;
+        g_ring.inflight--;
+        head++;
+    }
+    __atomic_store_n(g_ring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* Reserve n consecutive SQEs, submitting or reaping to make room; NULL if the ring is unusable. */
+static struct io_uring_sqe *io_get_sqes(unsigned n) {
+    while (g_ring.inflight + n > g_ring.entries) {
+        if (!io_enter(1)) return NULL;
+        io_reap();
+    }
+    unsigned tail = *g_ring.sq_tail;
+    while (tail + n - __atomic_load_n(g_ring.sq_head, __ATOMIC_ACQUIRE) > g_ring.entries) {
+        if (!io_enter(0)) return NULL;
+    }
+    for (unsigned i = 0; i < n; i++) {
+        unsigned idx = (tail + i) & *g_ring.sq_mask;
+        g_ring.sq_array[idx] = idx;
+        memset(&g_ring.sqes[idx], 0, sizeof(struct io_uring_sqe));
+    }
+    return &g_ring.sqes[tail & *g_ring.sq_mask];
+}
+
+static void io_commit_sqes(unsigned n) {
+    __atomic_store_n(g_ring.sq_tail, *g_ring.sq_tail + n, __ATOMIC_RELEASE);
+    g_ring.queued += n;
+    g_ring.inflight += n;
+}
+
+static void io_wait_op(IoOp *op) {
+    while (op->pending > 0) {
+        if (!io_enter(1)) break;
+        io_reap();
+    }
+}
+
+/* Start reading a whole file in the background; read_file() picks it up. */
+static void io_prefetch(const char *path) {
+    if (g_ring.fd < 0) return;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { close(fd); return; }
+
+    IoOp *op = (IoOp *)calloc(1, sizeof(IoOp));
+    char *buf = malloc((size_t)st.st_size + 1);
+    char *p = strdup(path);
+    pthread_mutex_lock(&g_io_lock);
+    struct io_uring_sqe *sqe = (op && buf && p) ? io_get_sqes(1) : NULL;
+    if (!sqe) { free(op); free(buf); free(p); close(fd); pthread_mutex_unlock(&g_io_lock); return; }
+
+    op->path = p;
+    op->fd = fd;
+    op->owns_fd = 1;
+    op->buf = buf;
+    op->len = (size_t)st.st_size;
+    op->is_read = 1;
+    op->pending = 1;
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = (unsigned)op->len;
+    sqe->off = 0;
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    io_commit_sqes(1);
+    io_enter(0);
+
+    op->next = g_io_reads;
+    g_io_reads = op;
+    pthread_mutex_unlock(&g_io_lock);
+}
+
+/* Buffer of a prefetched file (ownership moves to the caller), or NULL if none is usable. */
+static char *io_take_prefetched(const char *path) {
+    pthread_mutex_lock(&g_io_lock);
+    IoOp *op = NULL;
+    for (IoOp **pp = &g_io_reads; *pp; pp = &(*pp)->next) {
+        if (strcmp((*pp)->path, path) != 0) continue;
+        op = *pp;
+        *pp = op->next;
+        io_wait_op(op);
+        break;
+    }
+    pthread_mutex_unlock(&g_io_lock);
+    if (op) {
+        /* still owned by the kernel (ring failure): leave buffer and fd alone */
+        if (op->pending > 0) return NULL;
+
+        char *buf = op->buf;
+        size_t got = op->res > 0 ? (size_t)op->res : 0;
+        if (op->res < 0) { free(buf); buf = NULL; }
+        else {
+            /* short read (file changed under us): finish synchronously */
+            while (got < op->len) {
+                ssize_t r = pread(op->fd, buf + got, op->len - got, (off_t)got);
+                if (r <= 0) break;
+                got += (size_t)r;
+            }
+            buf[got] = '\0';
+        }
+        close(op->fd);
+        free(op->path);
+        free(op);
+        return buf;
+    }
+    return NULL;
+}
+
+static IoOp *io_new_write(const char *path, int fd, const char *data, size_t len) {
+    IoOp *op = (IoOp *)calloc(1, sizeof(IoOp));
+    if (!op) return NULL;
+    op->path = strdup(path);
+    op->fd = fd;
+    op->buf = malloc(len ? len : 1);
+    if (op->buf) memcpy(op->buf, data, len);
+    op->len = len;
+    return op;
+}
+
+static void io_queue_write(const char *path, int fd, const char *data, size_t len) {
+    IoOp *op = io_new_write(path, fd, data, len);
+    if (!op) return;
+    *g_io_writes_tail = op;
+    g_io_writes_tail = &op->next;
+}
+
+/* A file derived from queued ones: written by the same flush once they are all on disk. */
+static void io_queue_dependent(const char *path, const char *data, size_t len) {
+    IoOp *op = io_new_write(path, -1, data, len);
+    if (!op) return;
+    *g_io_dependent_tail = op;
+    g_io_dependent_tail = &op->next;
+}
+
+/* A file that records how far the others got: written by the same flush after all of them. */
+static void io_queue_last(const char *path, const char *data, size_t len) {
+    IoOp *op = io_new_write(path, -1, data, len);
+    if (!op) return;
+    *g_io_last_tail = op;
+    g_io_last_tail = &op->next;
+}
+
+static void io_defer_writes(int on) { g_io_deferring = on; }
+
+/* unlink(path) now, or after the queued writes are durable when deferring */
+static int io_remove_after_writes(const char *path) {
+    if (!g_io_deferring) return unlink(path) == 0;
+    if (access(path, F_OK) != 0) return 0;
+    IoUnlink *u = (IoUnlink *)calloc(1, sizeof(IoUnlink));
+    if (!u || !(u->path = strdup(path))) { free(u); return 0; }
+    u->next = g_io_unlinks;
+    g_io_unlinks = u;
+    return 1;
+}
+
+static int io_write_all_sync(IoOp *op, size_t from) {
+    size_t off = from;
+    while (off < op->len) {
+        ssize_t r = op->owns_fd ? pwrite(op->fd, op->buf + off, op->len - off, (off_t)off)
+                                : write(op->fd, op->buf + off, op->len - off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return 0;
+        off += (size_t)r;
+    }
+    return 1;
+}
+
+static void io_free_op(IoOp *op) {
+    free(op->buf);
+    free(op->tmp);
+    free(op->path);
+    free(op);
+}
+
+/* Make renames in path's directory durable. */
+static void io_fsync_dir_of(const char *path) {
+    char dir[1024];
+    const char *slash = strrchr(path, '/');
+    if (slash) snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+    else snprintf(dir, sizeof(dir), ".");
+    int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    if (fsync(fd) != 0) LOG("IO: fsync of %s failed (%s)", dir, strerror(errno));
+    close(fd);
+}
+
+/*
+   Write and fsync one list of files: each goes to PATH.tmp, opened up front, then
+   each write is linked to its fsync and the whole list goes to the kernel in as few
+   io_uring_enter calls as the ring allows. Only if every file made it to disk are
+   the temporaries renamed into place (in list order) and their directories fsynced;
+   otherwise they are removed and the old files stay. Pipes/ttys (stdout) are
+   written but not fsynced. Frees the list; returns 1 if every file landed.
+*/
+static int io_write_batch(IoOp *ops, int *nfiles) {
+    int ok = 1;
+
+    for (IoOp *op = ops; op; op = op->next) {
+        (*nfiles)++;
+        if (!op->buf) { ok = 0; continue; }
+        if (op->fd < 0) {
+            size_t n = strlen(op->path);
+            op->tmp = malloc(n + 5);
+            if (!op->tmp) { ok = 0; continue; }
+            memcpy(op->tmp, op->path, n);
+            memcpy(op->tmp + n, ".tmp", 5);
+            op->fd = open(op->tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            op->owns_fd = 1;
+            if (op->fd < 0) { LOG("IO: cannot open %s (%s)", op->tmp, strerror(errno)); ok = 0; continue; }
+        }
+        struct stat st;
+        op->do_fsync = fstat(op->fd, &st) == 0 && S_ISREG(st.st_mode);
+
+        struct io_uring_sqe *sqe = g_ring.fd >= 0 ? io_get_sqes(op->do_fsync ? 2 : 1) : NULL;
+        if (!sqe) continue; /* written synchronously below */
+
+        op->pending = op->do_fsync ? 2 : 1;
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = op->fd;
+        sqe->addr = (uint64_t)(uintptr_t)op->buf;
+        sqe->len = (unsigned)op->len;
+        sqe->off = op->owns_fd ? 0 : (uint64_t)-1; /* -1: current position (stdout) */
+        sqe->user_data = (uint64_t)(uintptr_t)op;
+        if (op->do_fsync) {
+            sqe->flags = IOSQE_IO_LINK;
+            struct io_uring_sqe *fs = &g_ring.sqes[(*g_ring.sq_tail + 1) & *g_ring.sq_mask];
+            fs->opcode = IORING_OP_FSYNC;
+            fs->fd = op->fd;
+            fs->user_data = (uint64_t)(uintptr_t)op | 1;
+        }
+        io_commit_sqes(op->pending);
+    }
+    if (g_ring.fd >= 0) {
+        while (g_ring.inflight > 0) {
+            if (!io_enter(g_ring.inflight)) break;
+            io_reap();
+        }
+    }
+
+    for (IoOp *op = ops; op; op = op->next) {
+        if (op->fd >= 0 && op->buf && op->pending == 0) {
+            /* not submitted (no ring / ring error), short write or cancelled fsync: finish inline */
+            size_t done = op->res > 0 ? (size_t)op->res : 0;
+            int done_ok = done == op->len && (!op->do_fsync || op->fsync_res == 0);
+            if (!done_ok) {
+                if (op->res < 0 && op->res != -ECANCELED && op->res != -EAGAIN) done = 0;
+                int w = io_write_all_sync(op, done);
+                if (w && op->do_fsync && fsync(op->fd) != 0) w = 0;
+                if (!w) { LOG("IO: write of %s failed", op->path); ok = 0; }
+            }
+        } else if (op->pending > 0) {
+            ok = 0;
+        }
+        if (op->owns_fd && op->fd >= 0 && op->pending == 0) { close(op->fd); op->fd = -1; }
+    }
+
+    char synced_dir[1024] = "";
+    int synced = 0;
+    for (IoOp *op = ops, *next; op; op = next) {
+        next = op->next;
+        if (op->tmp && op->fd < 0 && op->pending == 0) {
+            if (!ok) {
+                unlink(op->tmp);
+            } else if (rename(op->tmp, op->path) != 0) {
+                LOG("IO: cannot rename %s (%s)", op->tmp, strerror(errno));
+                unlink(op->tmp);
+                ok = 0;
+            }
+        }
+        /* files come grouped by directory: one fsync per run of the same directory */
+        if (ok && op->tmp) {
+            const char *slash = strrchr(op->path, '/');
+            int dl = slash ? (int)(slash - op->path) : 0;
+            if (!synced || (int)strlen(synced_dir) != dl || strncmp(synced_dir, op->path, (size_t)dl) != 0) {
+                io_fsync_dir_of(op->path);
+                snprintf(synced_dir, sizeof(synced_dir), "%.*s", dl, op->path);
+                synced = 1;
+            }
+        }
+        if (op->pending == 0) free(op->buf);
+        free(op->path);
+        free(op->tmp);
+        free(op);
+    }
+    return ok;
+}
+
+/*
+   Write and fsync everything queued while deferring, then the dependent files (only
+   if all of the first round landed), then perform the deferred removals, then the
+   write_file_last() files (only if everything before landed).
+   Returns 1 if every file made it to disk.
+*/
+static int io_flush_writes(void) {
+    g_io_deferring = 0;
+    int nfiles = 0;
+
+    IoOp *ops = g_io_writes, *dependent = g_io_dependent, *last = g_io_last;
+    g_io_writes = g_io_dependent = g_io_last = NULL;
+    g_io_writes_tail = &g_io_writes;
+    g_io_dependent_tail = &g_io_dependent;
+    g_io_last_tail = &g_io_last;
+
+    int ok = io_write_batch(ops, &nfiles);
+    if (ok) {
+        ok = io_write_batch(dependent, &nfiles);
+    } else if (dependent) {
+        LOG("IO: primary writes failed; derived files not written");
+        for (IoOp *op = dependent, *next; op; op = next) { next = op->next; io_free_op(op); }
+    }
+
+    for (IoUnlink *u = g_io_unlinks, *next; u; u = next) {
+        next = u->next;
+        if (ok) unlink(u->path);
+        free(u->path);
+        free(u);
+    }
+    g_io_unlinks = NULL;
+
+    if (ok) {
+        ok = io_write_batch(last, &nfiles);
+    } else if (last) {
+        LOG("IO: writes failed; %s left as it was", last->path);
+        for (IoOp *op = last, *next; op; op = next) { next = op->next; io_free_op(op); }
+    }
+
+    LOG("IO: flushed %d file(s) via %s", nfiles, g_ring.fd >= 0 ? "io_uring" : "syscalls");
+    return ok;
+}
+
+/* ----------------- precompressed siblings of output files (--precompress) ----------------- */
+
+/*
+   With --precompress every output that is served as a static file (README sections,
+   data/wrs.json, the data/store tables) gets FILE.gz, and FILE.zst when built with
+   zstd (WR_ZSTD), so a gzip_static/zstd_static server never compresses on request.
+   Siblings are redone only when the file's content changed (or one is missing). A
+   worker thread compresses while the rest of the run continues; precompress_finish()
+   waits for it and hands the siblings to the batched writer (io_queue_dependent), so
+   they land in the same flush as the files they describe and only after them. Outside
+   a batch each sibling is written to FILE.gz.tmp and renamed into place.
+*/
+#include <zlib.h>
+#ifdef WR_ZSTD
+#include <zstd.h>
+#endif
+
+typedef struct PcJob {
+    char *path;
+    char *data;
+    size_t len;
+    struct PcJob *next;
+} PcJob;
+
+static int g_precompress = 0;
+static pthread_mutex_t g_pc_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_pc_cond = PTHREAD_COND_INITIALIZER;
+static PcJob *g_pc_head = NULL, **g_pc_tail = &g_pc_head;
+static PcJob *g_pc_done = NULL, **g_pc_done_tail = &g_pc_done;   /* compressed siblings to write */
+static int g_pc_closing = 0, g_pc_running = 0;
+static pthread_t g_pc_thread;
+
+static int pc_write_sibling(const char *dst, const void *data, size_t len) {
+    char tmp[1040];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", dst);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return 0;
+    int ok = fwrite(data, 1, len, f) == len;
+    if (fclose(f) != 0) ok = 0;
+    if (ok && rename(tmp, dst) == 0) return 1;
+    unlink(tmp);
+    return 0;
+}
+
+/* Worker side: keep a compressed sibling until precompress_finish() writes it. */
+static int pc_emit(const char *path, const char *ext, const void *data, size_t len) {
+    PcJob *o = (PcJob *)calloc(1, sizeof(PcJob));
+    if (!o || asprintf(&o->path, "%s%s", path, ext) < 0 || !(o->data = malloc(len ? len : 1))) {
+        if (o) free(o->path);
+        free(o);
+        return 0;
+    }
+    memcpy(o->data, data, len);
+    o->len = len;
+    pthread_mutex_lock(&g_pc_lock);
+    *g_pc_done_tail = o;
+    g_pc_done_tail = &o->next;
+    pthread_mutex_unlock(&g_pc_lock);
+    return 1;
+}
+
+static int pc_gzip(const char *path, const char *data, size_t len) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    /* 15 + 16: gzip wrapper rather than zlib */
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) return 0;
+    uLong cap = deflateBound(&zs, (uLong)len);
+    unsigned char *out = malloc(cap);
+    int ok = 0;
+    if (out) {
+        zs.next_in = (Bytef *)data;
+        zs.avail_in = (uInt)len;
+        zs.next_out = out;
+        zs.avail_out = (uInt)cap;
+        if (deflate(&zs, Z_FINISH) == Z_STREAM_END) ok = pc_emit(path, ".gz", out, zs.total_out);
+    }
+    deflateEnd(&zs);
+    free(out);
+    return ok;
+}
+
+#ifdef WR_ZSTD
+static int pc_zstd(const char *path, const char *data, size_t len) {
+    size_t cap = ZSTD_compressBound(len);
+    void *out = malloc(cap);
+    if (!out) return 0;
+    size_t n = ZSTD_compress(out, cap, data, len, 19);
+    int ok = !ZSTD_isError(n) && pc_emit(path, ".zst", out, n);
+    free(out);
+    return ok;
+}
+#endif
+
+static void *pc_worker(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&g_pc_lock);
+    for (;;) {
+        while (!g_pc_head && !g_pc_closing) pthread_cond_wait(&g_pc_cond, &g_pc_lock);
+        PcJob *j = g_pc_head;
+        if (!j) break;
+        g_pc_head = j->next;
+        if (!g_pc_head) g_pc_tail = &g_pc_head;
+        pthread_mutex_unlock(&g_pc_lock);
+
+        int ok = pc_gzip(j->path, j->data, j->len);
+#ifdef WR_ZSTD
+        ok = pc_zstd(j->path, j->data, j->len) && ok;
+#endif
+        if (!ok) LOG("Precompress: failed for %s", j->path);
+        free(j->path);
+        free(j->data);
+        free(j);
+
+        pthread_mutex_lock(&g_pc_lock);
+    }
+    pthread_mutex_unlock(&g_pc_lock);
+    return NULL;
+}
+
+static int pc_sibling_missing(const char *path) {
+    char p[1024];
+    snprintf(p, sizeof(p), "%s.gz", path);
+    if (access(p, F_OK) != 0) return 1;
+#ifdef WR_ZSTD
+    snprintf(p, sizeof(p), "%s.zst", path);
+    if (access(p, F_OK) != 0) return 1;
+#endif
+    return 0;
+}
+
+/* Compress a copy of data into path's siblings on the worker (started on first use). */
+static void precompress_queue(const char *path, const char *data, size_t len) {
+    if (!g_precompress) return;
+    PcJob *j = (PcJob *)calloc(1, sizeof(PcJob));
+    if (!j || !(j->path = strdup(path)) || !(j->data = malloc(len + 1))) {
+        if (j) free(j->path);
+        free(j);
+        LOG("Precompress: no memory for %s", path);
+        return;
+    }
+    memcpy(j->data, data, len);
+    j->len = len;
+
+    pthread_mutex_lock(&g_pc_lock);
+    if (!g_pc_running) {
+        g_pc_closing = 0;
+        g_pc_running = pthread_create(&g_pc_thread, NULL, pc_worker, NULL) == 0;
+    }
+    *g_pc_tail = j;
+    g_pc_tail = &j->next;
+    int inline_job = !g_pc_running;
+    pthread_cond_signal(&g_pc_cond);
+    pthread_mutex_unlock(&g_pc_lock);
+
+    /* no thread: drain here */
+    if (inline_job) {
+        pthread_mutex_lock(&g_pc_lock);
+        g_pc_closing = 1;
+        pthread_mutex_unlock(&g_pc_lock);
+        pc_worker(NULL);
+    }
+}
+
+/*
+   Wait for the worker, then write every sibling: queued behind the batch's primary
+   files while writes are deferred, otherwise to disk now.
+*/
+static void precompress_finish(void) {
+    pthread_mutex_lock(&g_pc_lock);
+    int running = g_pc_running;
+    g_pc_closing = 1;
+    pthread_cond_signal(&g_pc_cond);
+    pthread_mutex_unlock(&g_pc_lock);
+    if (running) pthread_join(g_pc_thread, NULL);
+    g_pc_running = 0;
+
+    PcJob *done = g_pc_done;
+    g_pc_done = NULL;
+    g_pc_done_tail = &g_pc_done;
+    for (PcJob *o = done, *next; o; o = next) {
+        next = o->next;
+        if (g_io_deferring) io_queue_dependent(o->path, o->data, o->len);
+        else if (!pc_write_sibling(o->path, o->data, o->len)) LOG("Precompress: cannot write %s", o->path);
+        free(o->path);
+        free(o->data);
+        free(o);
+    }
+}
+
+/* The file itself is going away: so are its siblings. */
+static void precompress_remove(const char *path) {
+    char p[1024];
+    snprintf(p, sizeof(p), "%s.gz", path);
+    unlink(p);
+    snprintf(p, sizeof(p), "%s.zst", path);
+    unlink(p);
+}
+
+/* ----------------- fs helpers ----------------- */
+
+static int ensure_dir(const char *path) {
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) return 1;
+    if (mkdir(path, 0755) == 0) return 1;
+    return 0;
+}
+
+static char *read_file(const char *path) {
+    char *pre = io_take_prefetched(path);
+    if (pre) return pre;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    if (fseek(f, 0, SEEK_END) != 0) { fclose(f); return NULL; }
+    long n = ftell(f);
+    if (n < 0) { fclose(f); return NULL; }
+    rewind(f);
+
+    char *buf = malloc((size_t)n + 1);
+    if (!buf) { fclose(f); return NULL; }
+    size_t r = fread(buf, 1, (size_t)n, f);
+    fclose(f);
+    buf[r] = '\0';
+    return buf;
+}
+
+static int write_file(const char *path, const char *data) {
+    free(io_take_prefetched(path)); /* never hand out the pre-write content later */
+    size_t n = strlen(data);
+    if (g_io_deferring) { io_queue_write(path, -1, data, n); return 1; }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    if (fwrite(data, 1, n, f) != n) { fclose(f); return 0; }
+    fclose(f);
+    return 1;
+}
+
+/* write_file() for a file that says how far the others got: in a batch it lands after them */
+static int write_file_last(const char *path, const char *data) {
+    if (!g_io_deferring) return write_file(path, data);
+    free(io_take_prefetched(path));
+    io_queue_last(path, data, strlen(data));
+    return 1;
+}
+
+/* Skip the write when the file already holds exactly this content (keeps git/mtime quiet);
+   the file's --precompress siblings follow it. */
+static int write_file_if_changed(const char *path, const char *data) {
+    char *cur = read_file(path);
+    int same = cur && strcmp(cur, data) == 0;
+    free(cur);
+    if (g_precompress && (!same || pc_sibling_missing(path))) precompress_queue(path, data, strlen(data));
+    return same ? 1 : write_file(path, data);
+}
+
+static int buf_append(Buffer *b, const char *s, size_t n) {
+    char *ptr = realloc(b->data, b->size + n + 1);
+    if (!ptr) return 0;
+    b->data = ptr;
+    memcpy(b->data + b->size, s, n);
+    b->size += n;
+    b->data[b->size] = '\0';
+    return 1;
+}
+
+/* ----------------- sampling profiler (--profile) ----------------- */
+
+/*
+   SIGPROF every ~1ms of CPU time; the handler walks the frame-pointer chain and
+   appends the return addresses to a preallocated pool (nothing else is safe in a
+   signal handler). Every thread that doesn't block SIGPROF can take samples, so a
+   sample is walked into a local buffer, reserved in the pool with one atomic add and
+   published by writing its depth word last. At exit the addresses are symbolized (our own statics from the
+   ELF .symtab, shared libraries via dladdr) and written as folded stacks,
+   "main;fetch_url;curl_easy_perform 42", ready for flamegraph.pl.
+   cJSON/curl/libc are usually built without frame pointers, so when a sample lands
+   in a library (or rbp is not a frame) the stack is scanned for the first return
+   address into our own code and the walk resumes from the frame record above it.
+*/
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <elf.h>
+#include <link.h>
+#include <dlfcn.h>
+#include <ucontext.h>
+
+#define PROF_HZ 997
+#define PROF_MAX_DEPTH 64
+#define PROF_POOL_WORDS (1u << 21) /* 16 MB of address space, touched lazily */
+
+static const char *g_profile_path = NULL;
+static uintptr_t *g_prof_pool = NULL;   /* [depth, pc0 (leaf), pc1, ...] per sample; depth 0: unwritten */
+static size_t g_prof_used = 0;          /* words reserved (atomic) */
+static size_t g_prof_samples = 0;       /* atomic */
+static size_t g_prof_dropped = 0;       /* atomic */
+static uintptr_t g_prof_stack_lo = 0, g_prof_stack_hi = 0;
+static uintptr_t g_prof_text_lo = 0, g_prof_text_hi = 0; /* our executable code */
+
+#define PROF_SCAN_WORDS 4096
+
+static int prof_in_text(uintptr_t a) { return a >= g_prof_text_lo && a < g_prof_text_hi; }
+
+/* [saved fp, return address] pair that looks like one of our frames */
+static int prof_frame_ok(uintptr_t fp, uintptr_t sp) {
+    if (fp < sp || fp + 2 * sizeof(uintptr_t) > g_prof_stack_hi || (fp & (sizeof(uintptr_t) - 1))) return 0;
+    const uintptr_t *frame = (const uintptr_t *)fp;
+    return frame[1] != 0;
+}
+
+static void prof_on_sigprof(int sig, siginfo_t *si, void *uc_) {
+    (void)sig; (void)si;
+    ucontext_t *uc = (ucontext_t *)uc_;
+    uintptr_t pc, fp, sp;
+#if defined(__x86_64__)
+    pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+    fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+    sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+    pc = (uintptr_t)uc->uc_mcontext.pc;
+    fp = (uintptr_t)uc->uc_mcontext.regs[29];
+    sp = (uintptr_t)uc->uc_mcontext.sp;
+#else
+    (void)uc;
+    return;
+#endif
+
+    uintptr_t out[PROF_MAX_DEPTH];
+    size_t depth = 0;
+    out[depth++] = pc;
+
+    /* only follow frames that stay on the main stack and move strictly upwards */
+    int on_stack = sp >= g_prof_stack_lo && sp < g_prof_stack_hi;
+    if (on_stack && (!prof_in_text(pc) || !prof_frame_ok(fp, sp))) {
+        /* in code without a frame pointer: the first return address into our code,
+           then the frame record above it */
+        const uintptr_t *w = (const uintptr_t *)sp;
+        size_t lim = (g_prof_stack_hi - sp) / sizeof(uintptr_t);
+        lim = lim > 2 ? lim - 2 : 0;
+        if (lim > PROF_SCAN_WORDS) lim = PROF_SCAN_WORDS;
+        size_t i = 0;
+        while (i < lim && !prof_in_text(w[i])) i++;
+        if (i < lim) {
+            out[depth++] = w[i];
+            for (i++; i < lim; i++) {
+                uintptr_t cand = (uintptr_t)&w[i];
+                if (w[i] > cand && w[i] < g_prof_stack_hi && prof_in_text(w[i + 1])) break;
+            }
+        }
+        if (i < lim) { fp = (uintptr_t)&w[i]; sp = fp; }
+        else on_stack = 0;
+    }
+    while (on_stack && depth < PROF_MAX_DEPTH) {
+        if (!prof_frame_ok(fp, sp)) break;
+        const uintptr_t *frame = (const uintptr_t *)fp;
+        out[depth++] = frame[1];
+        if (frame[0] <= fp) break;
+        sp = fp;
+        fp = frame[0];
+    }
+
+    size_t at = __atomic_fetch_add(&g_prof_used, 1 + depth, __ATOMIC_RELAXED);
+    if (at + 1 + depth > PROF_POOL_WORDS) {
+        __atomic_add_fetch(&g_prof_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    memcpy(g_prof_pool + at + 1, out, depth * sizeof(uintptr_t));
+    __atomic_store_n(&g_prof_pool[at], (uintptr_t)depth, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&g_prof_samples, 1, __ATOMIC_RELAXED);
+}
+
+typedef struct { uintptr_t addr, size; const char *name; } ProfSym;
+
+static ProfSym *g_prof_syms = NULL;
+static size_t g_prof_nsyms = 0;
+static uintptr_t g_prof_exe_bias = 0;
+
+static int prof_sym_cmp(const void *a, const void *b) {
+    const ProfSym *x = (const ProfSym *)a, *y = (const ProfSym *)b;
+    return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+static int prof_first_object(struct dl_phdr_info *info, size_t size, void *data) {
+    (void)size; (void)data;
+    g_prof_exe_bias = (uintptr_t)info->dlpi_addr;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+        if (ph->p_type != PT_LOAD || !(ph->p_flags & PF_X)) continue;
+        g_prof_text_lo = g_prof_exe_bias + (uintptr_t)ph->p_vaddr;
+        g_prof_text_hi = g_prof_text_lo + (uintptr_t)ph->p_memsz;
+        break;
+    }
+    return 1; /* the first object is the executable itself */
+}
+
+/* Function symbols of our own binary, including statics that dladdr cannot see.
+   The mapping is kept for the lifetime of the process (names point into it). */
+static void prof_load_exe_symbols(void) {
+    int fd = open("/proc/self/exe", O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Elf64_Ehdr)) { close(fd); return; }
+    const unsigned char *img = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (img == MAP_FAILED) return;
+
+    const Elf64_Ehdr *eh = (const Elf64_Ehdr *)img;
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS64 ||
+        eh->e_shoff == 0 || eh->e_shoff + (size_t)eh->e_shnum * sizeof(Elf64_Shdr) > (size_t)st.st_size) return;
+    const Elf64_Shdr *sh = (const Elf64_Shdr *)(img + eh->e_shoff);
+
+    /* prefer the full .symtab; a stripped binary only has .dynsym */
+    const Elf64_Shdr *symtab = NULL;
+    for (int i = 0; i < eh->e_shnum; i++) if (sh[i].sh_type == SHT_SYMTAB) symtab = &sh[i];
+    if (!symtab) for (int i = 0; i < eh->e_shnum; i++) if (sh[i].sh_type == SHT_DYNSYM) symtab = &sh[i];
+    if (!symtab || symtab->sh_link >= eh->e_shnum) return;
+    const Elf64_Shdr *strtab = &sh[symtab->sh_link];
+    if (symtab->sh_offset + symtab->sh_size > (size_t)st.st_size ||
+        strtab->sh_offset + strtab->sh_size > (size_t)st.st_size) return;
+
+    const Elf64_Sym *syms = (const Elf64_Sym *)(img + symtab->sh_offset);
+    size_t n = symtab->sh_size / sizeof(Elf64_Sym);
+    g_prof_syms = (ProfSym *)calloc(n ? n : 1, sizeof(ProfSym));
+    if (!g_prof_syms) return;
+    for (size_t i = 0; i < n; i++) {
+        if (ELF64_ST_TYPE(syms[i].st_info) != STT_FUNC || syms[i].st_value == 0 || syms[i].st_size == 0) continue;
+        if (syms[i].st_name >= strtab->sh_size) continue;
+        ProfSym *ps = &g_prof_syms[g_prof_nsyms++];
+        ps->addr = g_prof_exe_bias + (uintptr_t)syms[i].st_value;
+        ps->size = (uintptr_t)syms[i].st_size;
+        ps->name = (const char *)(img + strtab->sh_offset + syms[i].st_name);
+    }
+    qsort(g_prof_syms, g_prof_nsyms, sizeof(ProfSym), prof_sym_cmp);
+}
+
+/* Not async-signal-safe; only called from prof_finish. */
+static const char *prof_symbolize(uintptr_t pc, char *tmp, size_t tmp_sz) {
+    size_t lo = 0, hi = g_prof_nsyms;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (g_prof_syms[mid].addr <= pc) lo = mid + 1; else hi = mid;
+    }
+    if (lo > 0 && pc < g_prof_syms[lo - 1].addr + g_prof_syms[lo - 1].size) return g_prof_syms[lo - 1].name;
+
+    Dl_info di;
+    if (dladdr((void *)pc, &di) && di.dli_fname) {
+        if (di.dli_sname) return di.dli_sname;
+        const char *base = strrchr(di.dli_fname, '/');
+        snprintf(tmp, tmp_sz, "[%s]", base ? base + 1 : di.dli_fname);
+        return tmp;
+    }
+    return "[unknown]";
+}
+
+typedef struct { char *line; } ProfLine;
+
+static int prof_line_cmp(const void *a, const void *b) {
+    return strcmp(((const ProfLine *)a)->line, ((const ProfLine *)b)->line);
+}
+
+static void prof_finish(void) {
+    struct itimerval off = {0};
+    setitimer(ITIMER_PROF, &off, NULL);
+    signal(SIGPROF, SIG_IGN);
+    if (!g_prof_pool) return;
+
+    prof_load_exe_symbols();
+
+    size_t used = __atomic_load_n(&g_prof_used, __ATOMIC_ACQUIRE);
+    size_t nsamples = __atomic_load_n(&g_prof_samples, __ATOMIC_ACQUIRE);
+    if (used > PROF_POOL_WORDS) used = PROF_POOL_WORDS;
+    ProfLine *lines = (ProfLine *)calloc(nsamples ? nsamples : 1, sizeof(ProfLine));
+    size_t nl = 0;
+
+    for (size_t at = 0; lines && at < used && nl < nsamples; ) {
+        /* a handler still running on another thread may not have published yet */
+        size_t depth = (size_t)__atomic_load_n(&g_prof_pool[at], __ATOMIC_ACQUIRE);
+        if (depth == 0 || depth > PROF_MAX_DEPTH || at + 1 + depth > used) break;
+        const uintptr_t *pcs = g_prof_pool + at + 1;
+        at += 1 + depth;
+
+        /* resolve leaf-first, stop at main, then emit root-first */
+        const char *names[PROF_MAX_DEPTH];
+        char tmp[PROF_MAX_DEPTH][64];
+        size_t nn = 0;
+        for (size_t i = 0; i < depth; i++) {
+            /* return addresses point past the call; step back into it */
+            uintptr_t pc = i == 0 ? pcs[i] : pcs[i] - 1;
+            names[nn] = prof_symbolize(pc, tmp[nn], sizeof(tmp[nn]));
+            if (strcmp(names[nn++], "main") == 0) break;
+        }
+
+        Buffer b = {0};
+        for (size_t i = nn; i-- > 0; ) {
+            buf_append(&b, names[i], strlen(names[i]));
+            if (i) buf_append(&b, ";", 1);
+        }
+        if (b.data) lines[nl++].line = b.data;
+    }
+
+    FILE *f = fopen(g_profile_path, "w");
+    if (!f) {
+        LOG("Profile: cannot write %s", g_profile_path);
+    } else {
+        qsort(lines, nl, sizeof(ProfLine), prof_line_cmp);
+        for (size_t i = 0; i < nl; ) {
+            size_t j = i + 1;
+            while (j < nl && strcmp(lines[j].line, lines[i].line) == 0) j++;
+            fprintf(f, "%s %zu\n", lines[i].line, j - i);
+            i = j;
+        }
+        fclose(f);
+        LOG("Profile: %zu samples (%zu dropped) -> %s", nl, __atomic_load_n(&g_prof_dropped, __ATOMIC_RELAXED),
+            g_profile_path);
+    }
+
+    for (size_t i = 0; i < nl; i++) free(lines[i].line);
+    free(lines);
+}
+
+/* [lo, hi) of the main thread's stack, from /proc/self/maps */
+static int prof_find_stack(uintptr_t *lo, uintptr_t *hi) {
+    FILE *f = fopen("/proc/self/maps", "r");
+    if (!f) return 0;
+    char line[512];
+    int found = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (!strstr(line, "[stack]")) continue;
+        unsigned long a, b;
+        if (sscanf(line, "%lx-%lx", &a, &b) == 2) { *lo = a; *hi = b; found = 1; }
+        break;
+    }
+    fclose(f);
+    return found;
+}
+
+static int prof_start(void) {
+#if !defined(__x86_64__) && !defined(__aarch64__)
+    LOG("Profile: no unwinder for this architecture");
+    return 0;
+#endif
+    g_prof_pool = mmap(NULL, PROF_POOL_WORDS * sizeof(uintptr_t), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (g_prof_pool == MAP_FAILED) { g_prof_pool = NULL; return 0; }
+    if (!prof_find_stack(&g_prof_stack_lo, &g_prof_stack_hi)) LOG("Profile: stack bounds unknown, leaf frames only");
+    dl_iterate_phdr(prof_first_object, NULL);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = prof_on_sigprof;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, NULL) != 0) return 0;
+
+    atexit(prof_finish);
+
+    struct itimerval it;
+    it.it_interval.tv_sec = 0;
+    it.it_interval.tv_usec = 1000000 / PROF_HZ;
+    it.it_value = it.it_interval;
+    return setitimer(ITIMER_PROF, &it, NULL) == 0;
+}
+
+/* ----------------- CPU feature dispatch for string kernels ----------------- */
+
+/*
+   The hot string kernels come in scalar, SSE4.2 and AVX2 flavours. isa_init() picks
+   the best one the CPU supports (CPUID via __builtin_cpu_supports) before anything
+   is hashed, so the binary itself needs no -march and is safe on mixed runners.
+   --force-isa=scalar|sse42|avx2 overrides the choice for benchmarking and testing.
+     hash     in-memory hash set/map hashing (FNV-1a scalar, CRC32C otherwise);
+              never persisted, so variants need not agree with each other
+     key_eq   equality of two byte strings of the same length
+     html_run length of the prefix that needs no HTML escaping
+     find     memmem(): first occurrence of needle in a bounded haystack
+     crc32c   CRC32C (Castagnoli) for store block checksums; persisted, so every
+              variant returns the same value (table-driven scalar, SSE4.2 crc32)
+*/
+
+typedef struct IsaOps {
+    const char *name;
+    uint64_t (*hash)(const char *s, size_t n);
+    int (*key_eq)(const char *a, const char *b, size_t n);
+    size_t (*html_run)(const char *s, size_t n);
+    const char *(*find)(const char *hay, size_t n, const char *needle, size_t m);
+    uint32_t (*crc32c)(uint32_t crc, const char *s, size_t n);
+} IsaOps;
+
+static const unsigned char g_html_special[256] = {
+    ['&'] = 1, ['<'] = 1, ['>'] = 1, ['"'] = 1, ['\''] = 1, ['|'] = 1,
+    ['\n'] = 1, ['\r'] = 1, ['\t'] = 1,
+};
+
+static uint64_t hash_scalar(const char *s, size_t n) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (uint64_t)(unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static int key_eq_scalar(const char *a, const char *b, size_t n) {
+    return memcmp(a, b, n) == 0;
+}
+
+static size_t html_run_scalar(const char *s, size_t n) {
+    size_t i = 0;
+    while (i < n && !g_html_special[(unsigned char)s[i]]) i++;
+    return i;
+}
+
+static const char *find_scalar(const char *hay, size_t n, const char *needle, size_t m) {
+    return memmem(hay, n, needle, m);
+}
+
+static uint32_t g_crc32c_table[256];
+
+static void crc32c_init_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0x82f63b78u & (0u - (c & 1)));
+        g_crc32c_table[i] = c;
+    }
+}
+
+static uint32_t crc32c_scalar(uint32_t crc, const char *s, size_t n) {
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) crc = (crc >> 8) ^ g_crc32c_table[(crc ^ (unsigned char)s[i]) & 0xff];
+    return ~crc;
+}
+
+static const IsaOps isa_scalar = { "scalar", hash_scalar, key_eq_scalar, html_run_scalar, find_scalar, crc32c_scalar };
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+static uint64_t hash_mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/* two independent CRC32C lanes over 8-byte words, folded and mixed */
+__attribute__((target("sse4.2")))
+static uint64_t hash_crc32c(const char *s, size_t n) {
+    uint64_t a = 0x243f6a88u ^ n, b = 0x85a308d3u;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint64_t x, y;
+        memcpy(&x, s + i, 8);
+        memcpy(&y, s + i + 8, 8);
+        a = _mm_crc32_u64(a, x);
+        b = _mm_crc32_u64(b, y);
+    }
+    if (i + 8 <= n) {
+        uint64_t x;
+        memcpy(&x, s + i, 8);
+        a = _mm_crc32_u64(a, x);
+        i += 8;
+    }
+    if (i < n) {
+        uint64_t x = 0;
+        memcpy(&x, s + i, n - i);
+        b = _mm_crc32_u64(b, x);
+    }
+    return hash_mix64((a << 32) ^ b ^ ((uint64_t)n << 56));
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const char *s, size_t n) {
+    uint64_t c = ~crc;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t x;
+        memcpy(&x, s + i, 8);
+        c = _mm_crc32_u64(c, x);
+    }
+    uint32_t c32 = (uint32_t)c;
+    for (; i < n; i++) c32 = _mm_crc32_u8(c32, (unsigned char)s[i]);
+    return ~c32;
+}
+
+__attribute__((target("sse4.2")))
+static int key_eq_sse42(const char *a, const char *b, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) return 0;
+    }
+    return memcmp(a + i, b + i, n - i) == 0;
+}
+
+/* PCMPESTRI "equal any" against the escape set, 16 bytes per step */
+__attribute__((target("sse4.2")))
+static size_t html_run_sse42(const char *s, size_t n) {
+    const __m128i set = _mm_setr_epi8('&', '<', '>', '"', '\'', '|', '\n', '\r', '\t', 0, 0, 0, 0, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(s + i));
+        int idx = _mm_cmpestri(set, 9, block, 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if (idx < 16) return i + (size_t)idx;
+    }
+    return i + html_run_scalar(s + i, n - i);
+}
+
+/* first/last-byte filter (Mula), then confirm the middle with memcmp */
+__attribute__((target("sse4.2")))
+static const char *find_sse42(const char *hay, size_t n, const char *needle, size_t m) {
+    if (m < 2 || m > n) return memmem(hay, n, needle, m);
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        __m128i bf = _mm_loadu_si128((const __m128i*)(hay + i));
+        __m128i bl = _mm_loadu_si128((const __m128i*)(hay + i + m - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, bf), _mm_cmpeq_epi8(last, bl)));
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, m - 2) == 0) return hay + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return memmem(hay + i, n - i, needle, m);
+}
+
+__attribute__((target("avx2")))
+static int key_eq_avx2(const char *a, const char *b, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        if ((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) != 0xFFFFFFFFu) return 0;
+    }
+    return memcmp(a + i, b + i, n - i) == 0;
+}
+
+__attribute__((target("avx2")))
+static size_t html_run_avx2(const char *s, size_t n) {
+    static const char set[] = { '&', '<', '>', '"', '\'', '|', '\n', '\r', '\t' };
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i hit = _mm256_setzero_si256();
+        for (size_t k = 0; k < sizeof(set); k++) {
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(set[k])));
+        }
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+    return i + html_run_scalar(s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static const char *find_avx2(const char *hay, size_t n, const char *needle, size_t m) {
+    if (m < 2 || m > n) return memmem(hay, n, needle, m);
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        __m256i bf = _mm256_loadu_si256((const __m256i*)(hay + i));
+        __m256i bl = _mm256_loadu_si256((const __m256i*)(hay + i + m - 1));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, bf), _mm256_cmpeq_epi8(last, bl)));
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, m - 2) == 0) return hay + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return memmem(hay + i, n - i, needle, m);
+}
+
+static const IsaOps isa_sse42 = { "sse42", hash_crc32c, key_eq_sse42, html_run_sse42, find_sse42, crc32c_sse42 };
+static const IsaOps isa_avx2 = { "avx2", hash_crc32c, key_eq_avx2, html_run_avx2, find_avx2, crc32c_sse42 };
+#endif
+
+static const IsaOps *g_isa = &isa_scalar;
+
+/* returns 0 if the forced ISA is unknown or not supported by this CPU */
+static int isa_init(const char *force) {
+    const IsaOps *best = &isa_scalar;
+    crc32c_init_table();
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    int has_sse42 = __builtin_cpu_supports("sse4.2");
+    int has_avx2 = has_sse42 && __builtin_cpu_supports("avx2");
+    if (has_avx2) best = &isa_avx2;
+    else if (has_sse42) best = &isa_sse42;
+
+    if (force) {
+        if (strcmp(force, "scalar") == 0) best = &isa_scalar;
+        else if (strcmp(force, "sse42") == 0 && has_sse42) best = &isa_sse42;
+        else if (strcmp(force, "avx2") == 0 && has_avx2) best = &isa_avx2;
+        else return 0;
+    }
+#else
+    if (force && strcmp(force, "scalar") != 0) return 0;
+#endif
+    g_isa = best;
+    return 1;
+}
+
+/* ----------------- phase metrics (wall time + hardware counters) ----------------- */
+
+/*
+   main() brackets each pipeline phase with phase_begin/phase_end. Wall time is always
+   kept; with --counters a perf_event_open group (cycles, instructions, cache misses,
+   branch misses; user space of this thread only) is read at the same boundaries.
+   Phases run on a thread of their own (load, render) bracket themselves with
+   thread_phase_begin/end, which open a group for that thread. Hosts without a PMU
+   or with a strict perf_event_paranoid fall back to wall time.
+*/
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+
+typedef enum {
+    PHASE_LOAD, PHASE_PRUNE, PHASE_ENRICH, PHASE_SCAN, PHASE_SORT, PHASE_SAVE, PHASE_RENDER, PHASE_COUNT
+} Phase;
+
+static const char *const k_phase_names[PHASE_COUNT] = {
+    "load", "prune", "enrich", "scan", "sort", "save", "render"
+};
+
+enum { PC_CYCLES, PC_INSTRUCTIONS, PC_CACHE_MISSES, PC_BRANCH_MISSES, PC_COUNT };
+
+typedef struct {
+    int ran;
+    long records;
+    double wall_ms;
+    uint64_t pc[PC_COUNT];
+    int no_pc;                /* ran (partly) on a thread whose group could not open */
+    struct timespec t0;
+    uint64_t pc0[PC_COUNT];
+} PhaseStat;
+
+static PhaseStat g_phase[PHASE_COUNT];
+static int g_counters_wanted = 0;
+static const char *g_metrics_path = NULL;
+static int g_pc_fd[PC_COUNT] = { -1, -1, -1, -1 };
+
+static int pc_open(uint64_t config, int group_fd) {
+    struct perf_event_attr pa;
+    memset(&pa, 0, sizeof(pa));
+    pa.size = sizeof(pa);
+    pa.type = PERF_TYPE_HARDWARE;
+    pa.config = config;
+    pa.disabled = group_fd < 0;
+    pa.exclude_kernel = 1;
+    pa.exclude_hv = 1;
+    pa.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &pa, 0, -1, group_fd, 0);
+}
+
+/* The counter group for the calling thread, enabled; 0 (fds -1) if it can't be had. */
+static int pc_group_open(int fd[PC_COUNT]) {
+    static const uint64_t cfg[PC_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for (int i = 0; i < PC_COUNT; i++) {
+        fd[i] = pc_open(cfg[i], i ? fd[0] : -1);
+        if (fd[i] < 0) {
+            for (int j = 0; j < i; j++) { close(fd[j]); fd[j] = -1; }
+            return 0;
+        }
+    }
+    ioctl(fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return 1;
+}
+
+static void pc_group_close(int fd[PC_COUNT]) {
+    for (int i = 0; i < PC_COUNT; i++) if (fd[i] >= 0) { close(fd[i]); fd[i] = -1; }
+}
+
+/* group values, scaled up if the PMU had to multiplex the group */
+static int pc_group_read(const int fd[PC_COUNT], uint64_t out[PC_COUNT]) {
+    if (fd[0] < 0) return 0;
+    uint64_t buf[3 + PC_COUNT];
+    if (read(fd[0], buf, sizeof(buf)) != (ssize_t)sizeof(buf) || buf[0] != PC_COUNT) return 0;
+    double scale = (buf[2] && buf[2] < buf[1]) ? (double)buf[1] / (double)buf[2] : 1.0;
+    for (int i = 0; i < PC_COUNT; i++) out[i] = (uint64_t)((double)buf[3 + i] * scale);
+    return 1;
+}
+
+static void counters_init(void) {
+    if (!pc_group_open(g_pc_fd)) LOG("Counters: perf_event_open failed (%s); wall time only", strerror(errno));
+}
+
+static int counters_read(uint64_t out[PC_COUNT]) {
+    return pc_group_read(g_pc_fd, out);
+}
+
+static void phase_begin(Phase p) {
+    PhaseStat *ps = &g_phase[p];
+    clock_gettime(CLOCK_MONOTONIC, &ps->t0);
+    counters_read(ps->pc0);
+}
+
+static void phase_end(Phase p, long records) {
+    PhaseStat *ps = &g_phase[p];
+    uint64_t now[PC_COUNT];
+    if (counters_read(now)) {
+        for (int i = 0; i < PC_COUNT; i++) ps->pc[i] += now[i] - ps->pc0[i];
+    }
+    ps->wall_ms += (double)elapsed_us_since(&ps->t0) / 1000.0;
+    ps->records = records;
+    ps->ran = 1;
+}
+
+/* A phase run on another thread, measured there (wall time, and that thread's counters). */
+typedef struct {
+    struct timespec t0;
+    int fd[PC_COUNT];
+    int have_pc;
+    uint64_t pc0[PC_COUNT], pc[PC_COUNT];
+    double wall_ms;
+} ThreadPhase;
+
+static void thread_phase_begin(ThreadPhase *tp) {
+    memset(tp, 0, sizeof(*tp));
+    for (int i = 0; i < PC_COUNT; i++) tp->fd[i] = -1;
+    if (g_pc_fd[0] >= 0 && pc_group_open(tp->fd)) tp->have_pc = pc_group_read(tp->fd, tp->pc0);
+    clock_gettime(CLOCK_MONOTONIC, &tp->t0);
+}
+
+static void thread_phase_end(ThreadPhase *tp) {
+    tp->wall_ms = (double)elapsed_us_since(&tp->t0) / 1000.0;
+    uint64_t now[PC_COUNT];
+    if (tp->have_pc && pc_group_read(tp->fd, now)) {
+        for (int i = 0; i < PC_COUNT; i++) tp->pc[i] = now[i] - tp->pc0[i];
+    } else {
+        tp->have_pc = 0;
+    }
+    pc_group_close(tp->fd);
+}
+
+/* called on the main thread once the phase's thread is joined */
+static void phase_add_thread(Phase p, const ThreadPhase *tp, long records) {
+    PhaseStat *ps = &g_phase[p];
+    ps->wall_ms += tp->wall_ms;
+    if (tp->have_pc) {
+        for (int i = 0; i < PC_COUNT; i++) ps->pc[i] += tp->pc[i];
+    } else {
+        ps->no_pc = 1;
+    }
+    ps->records = records;
+    ps->ran = 1;
+}
+
+static double per_record(uint64_t v, long records) {
+    return records > 0 ? (double)v / (double)records : 0.0;
+}
+
+/* one line per phase in the run log, and the same numbers as JSON for --metrics */
+static void phases_report(time_t now) {
+    int have_pc = g_pc_fd[0] >= 0;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        const PhaseStat *ps = &g_phase[p];
+        if (!ps->ran) continue;
+        if (have_pc && !ps->no_pc) {
+            LOG("Phase %-6s %9.2f ms  records=%ld ipc=%.2f cache-miss/rec=%.1f branch-miss/rec=%.1f",
+                k_phase_names[p], ps->wall_ms, ps->records,
+                ps->pc[PC_CYCLES] ? (double)ps->pc[PC_INSTRUCTIONS] / (double)ps->pc[PC_CYCLES] : 0.0,
+                per_record(ps->pc[PC_CACHE_MISSES], ps->records),
+                per_record(ps->pc[PC_BRANCH_MISSES], ps->records));
+        } else {
+            LOG("Phase %-6s %9.2f ms  records=%ld", k_phase_names[p], ps->wall_ms, ps->records);
+        }
+    }
+
+    LOG("Transport: requests=%ld ok=%ld failed=%ld attempts=%ld retries=%ld "
+        "injected 429=%ld 5xx=%ld truncated=%ld timeout=%ld sim_wait=%.0fms",
+        g_tx.requests, g_tx.ok, g_tx.failed, g_tx.attempts, g_tx.retries,
+        g_tx.inj_429, g_tx.inj_5xx, g_tx.inj_trunc, g_tx.inj_timeout, g_tx.sim_wait_ms);
+
+    if (!g_metrics_path) return;
+
+    cJSON *doc = cJSON_CreateObject();
+    cJSON_AddNumberToObject(doc, "now", (double)now);
+    cJSON_AddStringToObject(doc, "isa", g_isa->name);
+    cJSON_AddBoolToObject(doc, "counters", have_pc);
+
+    cJSON *tx = cJSON_AddObjectToObject(doc, "transport");
+    cJSON_AddStringToObject(tx, "faults", g_faults_on ? g_faults.name : "none");
+    cJSON_AddNumberToObject(tx, "requests", (double)g_tx.requests);
+    cJSON_AddNumberToObject(tx, "ok", (double)g_tx.ok);
+    cJSON_AddNumberToObject(tx, "failed", (double)g_tx.failed);
+    cJSON_AddNumberToObject(tx, "attempts", (double)g_tx.attempts);
+    cJSON_AddNumberToObject(tx, "retries", (double)g_tx.retries);
+    cJSON_AddNumberToObject(tx, "injected_429", (double)g_tx.inj_429);
+    cJSON_AddNumberToObject(tx, "injected_5xx", (double)g_tx.inj_5xx);
+    cJSON_AddNumberToObject(tx, "injected_truncated", (double)g_tx.inj_trunc);
+    cJSON_AddNumberToObject(tx, "injected_timeout", (double)g_tx.inj_timeout);
+    cJSON_AddNumberToObject(tx, "sim_wait_ms", g_tx.sim_wait_ms);
+    cJSON *phases = cJSON_AddArrayToObject(doc, "phases");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        const PhaseStat *ps = &g_phase[p];
+        if (!ps->ran) continue;
+        cJSON *o = cJSON_CreateObject();
+        cJSON_AddStringToObject(o, "name", k_phase_names[p]);
+        cJSON_AddNumberToObject(o, "wall_ms", ps->wall_ms);
+        cJSON_AddNumberToObject(o, "records", (double)ps->records);
+        if (have_pc && !ps->no_pc) {
+            cJSON_AddNumberToObject(o, "cycles", (double)ps->pc[PC_CYCLES]);
+            cJSON_AddNumberToObject(o, "instructions", (double)ps->pc[PC_INSTRUCTIONS]);
+            cJSON_AddNumberToObject(o, "cache_misses", (double)ps->pc[PC_CACHE_MISSES]);
+            cJSON_AddNumberToObject(o, "branch_misses", (double)ps->pc[PC_BRANCH_MISSES]);
+            cJSON_AddNumberToObject(o, "ipc",
+                ps->pc[PC_CYCLES] ? (double)ps->pc[PC_INSTRUCTIONS] / (double)ps->pc[PC_CYCLES] : 0.0);
+            cJSON_AddNumberToObject(o, "cache_misses_per_record", per_record(ps->pc[PC_CACHE_MISSES], ps->records));
+            cJSON_AddNumberToObject(o, "branch_misses_per_record", per_record(ps->pc[PC_BRANCH_MISSES], ps->records));
+        }
+        cJSON_AddItemToArray(phases, o);
+    }
+    char *out = cJSON_Print(doc);
+    cJSON_Delete(doc);
+    if (!out) return;
+    if (!write_file(g_metrics_path, out)) LOG("Metrics: cannot write %s", g_metrics_path);
+    free(out);
+}
+
+/* ----------------- fast string hash set (run_id + processed keys) ----------------- */
+
+typedef struct StrSet {
+    char **keys;
+    uint64_t *hashes;
+    size_t *lens;
+    size_t cap;
+    size_t len;
+} StrSet;
+
+static uint64_t fnv1a_64_update(uint64_t h, const char *s) {
+    for (const unsigned char *p = (const unsigned char*)(s ? s : ""); *p; p++) {
+        h ^= (uint64_t)(*p);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Stable hash for anything persisted (replay file names, store ids); see g_isa->hash for in-memory use. */
+static uint64_t fnv1a_64(const char *s) {
+    return fnv1a_64_update(1469598103934665603ULL, s);
+}
+
+static int strset_init(StrSet *s, size_t initial_cap) {
+    if (!s) return 0;
+    size_t cap = 1;
+    while (cap < initial_cap) cap <<= 1;
+    s->keys = calloc(cap, sizeof(char*));
+    s->hashes = calloc(cap, sizeof(uint64_t));
+    s->lens = calloc(cap, sizeof(size_t));
+    if (!s->keys || !s->hashes || !s->lens) {
+        free(s->keys);
+        free(s->hashes);
+        free(s->lens);
+        s->keys = NULL;
+        s->hashes = NULL;
+        s->lens = NULL;
+        return 0;
+    }
+    s->cap = cap;
+    s->len = 0;
+    return 1;
+}
+
+static void strset_free(StrSet *s) {
+    if (!s || !s->keys) return;
+    for (size_t i = 0; i < s->cap; i++) free(s->keys[i]);
+    free(s->keys);
+    free(s->hashes);
+    free(s->lens);
+    s->keys = NULL;
+    s->hashes = NULL;
+    s->lens = NULL;
+    s->cap = 0;
+    s->len = 0;
+}
+
+static int strset_rehash(StrSet *s, size_t newcap) {
+    StrSet ns = {0};
+    if (!strset_init(&ns, newcap)) return 0;
+
+    for (size_t i = 0; i < s->cap; i++) {
+        char *k = s->keys[i];
+        if (!k) continue;
+        uint64_t h = s->hashes[i];
+        size_t mask = ns.cap - 1;
+        size_t idx = (size_t)h & mask;
+        while (ns.keys[idx]) idx = (idx + 1) & mask;
+        ns.keys[idx] = k;
+        ns.hashes[idx] = h;
+        ns.lens[idx] = s->lens[i];
+        ns.len++;
+        s->keys[i] = NULL;
+    }
+
+    free(s->keys);
+    free(s->hashes);
+    free(s->lens);
+    *s = ns;
+    return 1;
+}
+
+/* probes compare the stored hash and length before touching the key bytes */
+static int strset_has(const StrSet *s, const char *key) {
+    if (!s || !s->keys || !key) return 0;
+    size_t n = strlen(key);
+    uint64_t h = g_isa->hash(key, n);
+    size_t mask = s->cap - 1;
+    size_t idx = (size_t)h & mask;
+    for (size_t probe = 0; probe < s->cap; probe++) {
+        char *k = s->keys[idx];
+        if (!k) return 0;
+        if (s->hashes[idx] == h && s->lens[idx] == n && g_isa->key_eq(k, key, n)) return 1;
+        idx = (idx + 1) & mask;
+    }
+    return 0;
+}
+
+static int strset_add(StrSet *s, const char *key) {
+    if (!s || !s->keys || !key) return 0;
+    if (s->len * 10 >= s->cap * 7) {
+        if (!strset_rehash(s, s->cap * 2)) return 0;
+    }
+    size_t n = strlen(key);
+    uint64_t h = g_isa->hash(key, n);
+    size_t mask = s->cap - 1;
+    size_t idx = (size_t)h & mask;
+    while (s->keys[idx]) {
+        if (s->hashes[idx] == h && s->lens[idx] == n && g_isa->key_eq(s->keys[idx], key, n)) return 1;
+        idx = (idx + 1) & mask;
+    }
+    s->keys[idx] = strdup(key);
+    if (!s->keys[idx]) return 0;
+    s->hashes[idx] = h;
+    s->lens[idx] = n;
+    s->len++;
+    return 1;
+}
+
+/* ----------------- string -> pointer map (store dimension lookups) ----------------- */
+
+typedef struct StrMap {
+    char **keys;
+    void **vals;
+    size_t cap;
+    size_t len;
+} StrMap;
+
+static int strmap_init(StrMap *m, size_t initial_cap) {
+    if (!m) return 0;
+    size_t cap = 1;
+    while (cap < initial_cap) cap <<= 1;
+    m->keys = calloc(cap, sizeof(char*));
+    m->vals = calloc(cap, sizeof(void*));
+    if (!m->keys || !m->vals) {
+        free(m->keys);
+        free(m->vals);
+        m->keys = NULL;
+        m->vals = NULL;
+        return 0;
+    }
+    m->cap = cap;
+    m->len = 0;
+    return 1;
+}
+
+static void strmap_free(StrMap *m) {
+    if (!m || !m->keys) return;
+    for (size_t i = 0; i < m->cap; i++) free(m->keys[i]);
+    free(m->keys);
+    free(m->vals);
+    m->keys = NULL;
+    m->vals = NULL;
+    m->cap = 0;
+    m->len = 0;
+}
+
+static int strmap_rehash(StrMap *m, size_t newcap) {
+    StrMap nm = {0};
+    if (!strmap_init(&nm, newcap)) return 0;
+
+    for (size_t i = 0; i < m->cap; i++) {
+        char *k = m->keys[i];
+        if (!k) continue;
+        size_t mask = nm.cap - 1;
+        size_t idx = (size_t)g_isa->hash(k, strlen(k)) & mask;
+        while (nm.keys[idx]) idx = (idx + 1) & mask;
+        nm.keys[idx] = k;
+        nm.vals[idx] = m->vals[i];
+        nm.len++;
+    }
+
+    free(m->keys);
+    free(m->vals);
+    *m = nm;
+    return 1;
+}
+
+static void *strmap_get(const StrMap *m, const char *key) {
+    if (!m || !m->keys || !key) return NULL;
+    size_t mask = m->cap - 1;
+    size_t idx = (size_t)g_isa->hash(key, strlen(key)) & mask;
+    for (size_t probe = 0; probe < m->cap; probe++) {
+        char *k = m->keys[idx];
+        if (!k) return NULL;
+        if (strcmp(k, key) == 0) return m->vals[idx];
+        idx = (idx + 1) & mask;
+    }
+    return NULL;
+}
+
+/* Like strmap_get(), but tells a stored NULL apart from a missing key. */
+static int strmap_find(const StrMap *m, const char *key, void **val) {
+    if (!m || !m->keys || !key) return 0;
+    size_t mask = m->cap - 1;
+    size_t idx = (size_t)g_isa->hash(key, strlen(key)) & mask;
+    for (size_t probe = 0; probe < m->cap; probe++) {
+        char *k = m->keys[idx];
+        if (!k) return 0;
+        if (strcmp(k, key) == 0) { *val = m->vals[idx]; return 1; }
+        idx = (idx + 1) & mask;
+    }
+    return 0;
+}
+
+/* Insert-if-absent; an existing key keeps its value. */
+static int strmap_put(StrMap *m, const char *key, void *val) {
+    if (!m || !m->keys || !key) return 0;
+    if (m->len * 10 >= m->cap * 7) {
+        if (!strmap_rehash(m, m->cap * 2)) return 0;
+    }
+    size_t mask = m->cap - 1;
+    size_t idx = (size_t)g_isa->hash(key, strlen(key)) & mask;
+    while (m->keys[idx]) {
+        if (strcmp(m->keys[idx], key) == 0) return 1;
+        idx = (idx + 1) & mask;
+    }
+    m->keys[idx] = strdup(key);
+    if (!m->keys[idx]) return 0;
+    m->vals[idx] = val;
+    m->len++;
+    return 1;
+}
+
+/* ----------------- sharded map (caches shared by --jobs check workers) ----------------- */
+
+/*
+   SHARD_COUNT StrMaps, each behind its own mutex. The shard is picked from the top
+   bits of the key hash, leaving the low bits to spread keys inside the shard, so
+   workers only wait on each other when their keys fall in the same shard. Writers
+   go through shmap_put() (insert-if-absent): when two workers race on a miss, the
+   first value in wins and the loser gets it back instead of its own.
+
+   Caches made with shmap_init_lru() also stamp every entry on use, so the memory
+   governor can drop the least recently used ones (shmap_shrink()). Sets that stand
+   for correctness (runIds, processedKeys) are plain maps and never shrink.
+*/
+#define SHARD_BITS 5
+#define SHARD_COUNT (1u << SHARD_BITS)
+
+typedef struct {
+    _Alignas(64) pthread_mutex_t lock;
+    StrMap map;
+} MapShard;
+
+typedef struct ShardMap {
+    MapShard shards[SHARD_COUNT];
+    void (*free_val)(void *);  /* values still in the map at shmap_free(); NULL: not owned */
+    int lru;                   /* values are LruSlots */
+    uint64_t tick;             /* use clock (atomic) */
+} ShardMap;
+
+typedef struct {
+    void *val;
+    uint64_t used;
+} LruSlot;
+
+static const char k_shmap_present[] = "";
+
+static int shmap_init(ShardMap *m, size_t initial_cap, void (*free_val)(void *)) {
+    size_t per = initial_cap / SHARD_COUNT;
+    for (unsigned i = 0; i < SHARD_COUNT; i++) {
+        pthread_mutex_init(&m->shards[i].lock, NULL);
+        if (!strmap_init(&m->shards[i].map, per < 8 ? 8 : per)) return 0;
+    }
+    m->free_val = free_val;
+    m->lru = 0;
+    m->tick = 0;
+    return 1;
+}
+
+static int shmap_init_lru(ShardMap *m, size_t initial_cap, void (*free_val)(void *)) {
+    if (!shmap_init(m, initial_cap, free_val)) return 0;
+    m->lru = 1;
+    return 1;
+}
+
+static void shmap_free_slot(ShardMap *m, void *v) {
+    if (m->lru) {
+        LruSlot *slot = (LruSlot *)v;
+        v = slot->val;
+        free(slot);
+    }
+    if (m->free_val) m->free_val(v);
+}
+
+static void shmap_free(ShardMap *m) {
+    for (unsigned i = 0; i < SHARD_COUNT; i++) {
+        StrMap *sm = &m->shards[i].map;
+        if ((m->free_val || m->lru) && sm->keys) {
+            for (size_t j = 0; j < sm->cap; j++) if (sm->keys[j]) shmap_free_slot(m, sm->vals[j]);
+        }
+        strmap_free(sm);
+        pthread_mutex_destroy(&m->shards[i].lock);
+    }
+}
+
+static MapShard *shmap_shard(ShardMap *m, const char *key) {
+    uint64_t h = g_isa->hash(key, strlen(key));
+    return &m->shards[h >> (64 - SHARD_BITS)];
+}
+
+/* 1 and *val if key is present (its value may be NULL). */
+static int shmap_get(ShardMap *m, const char *key, void **val) {
+    if (!key) return 0;
+    MapShard *sh = shmap_shard(m, key);
+    pthread_mutex_lock(&sh->lock);
+    int found = strmap_find(&sh->map, key, val);
+    if (found && m->lru) {
+        LruSlot *slot = (LruSlot *)*val;
+        slot->used = __atomic_add_fetch(&m->tick, 1, __ATOMIC_RELAXED);
+        *val = slot->val;
+    }
+    pthread_mutex_unlock(&sh->lock);
+    return found;
+}
+
+/*
+   Insert-if-absent. Returns 1 when val went in (the map owns it now); otherwise 0
+   with *cur set to the value already there, or to NULL if there was no memory.
+*/
+static int shmap_put(ShardMap *m, const char *key, void *val, void **cur) {
+    if (!key) { *cur = NULL; return 0; }
+    LruSlot *slot = NULL;
+    if (m->lru) {
+        slot = malloc(sizeof(*slot));
+        if (!slot) { *cur = NULL; return 0; }
+        slot->val = val;
+        slot->used = __atomic_add_fetch(&m->tick, 1, __ATOMIC_RELAXED);
+    }
+    MapShard *sh = shmap_shard(m, key);
+    pthread_mutex_lock(&sh->lock);
+    int stored = 0;
+    if (!strmap_find(&sh->map, key, cur)) {
+        stored = strmap_put(&sh->map, key, slot ? (void *)slot : val);
+        *cur = stored ? val : NULL;
+    } else if (slot) {
+        *cur = ((LruSlot *)*cur)->val;
+    }
+    pthread_mutex_unlock(&sh->lock);
+    if (!stored) free(slot);
+    return stored;
+}
+
+/* Set use: 1 if present. */
+static int shmap_has(ShardMap *m, const char *key) {
+    void *v;
+    return shmap_get(m, key, &v);
+}
+
+/* Set use: 1 if key was added by this call, 0 if it was already there. */
+static int shmap_add(ShardMap *m, const char *key) {
+    void *cur;
+    return shmap_put(m, key, (void *)k_shmap_present, &cur);
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+   LRU maps only, and only while no value handed out by shmap_get()/shmap_put() is
+   still in use: drop the least recently used entries until about keep (0..1) of
+   them are left. Returns how many went.
+*/
+static size_t shmap_shrink(ShardMap *m, double keep) {
+    if (!m->lru) return 0;
+    size_t n = 0;
+    for (unsigned i = 0; i < SHARD_COUNT; i++) n += m->shards[i].map.len;
+    size_t keep_n = (size_t)((double)n * keep);
+    if (keep_n >= n) return 0;
+
+    /* entries used at or after the cutoff stay */
+    uint64_t cutoff = UINT64_MAX;
+    if (keep_n > 0) {
+        uint64_t *stamps = malloc(n * sizeof(uint64_t));
+        if (!stamps) return 0;
+        size_t k = 0;
+        for (unsigned i = 0; i < SHARD_COUNT; i++) {
+            StrMap *sm = &m->shards[i].map;
+            for (size_t j = 0; j < sm->cap && k < n; j++)
+                if (sm->keys[j]) stamps[k++] = ((LruSlot *)sm->vals[j])->used;
+        }
+        qsort(stamps, k, sizeof(uint64_t), cmp_u64);
+        cutoff = stamps[k - keep_n];
+        free(stamps);
+    }
+
+    size_t dropped = 0;
+    for (unsigned i = 0; i < SHARD_COUNT; i++) {
+        MapShard *sh = &m->shards[i];
+        pthread_mutex_lock(&sh->lock);
+        StrMap nm = {0};
+        if (strmap_init(&nm, sh->map.cap)) {
+            for (size_t j = 0; j < sh->map.cap; j++) {
+                if (!sh->map.keys[j]) continue;
+                LruSlot *slot = (LruSlot *)sh->map.vals[j];
+                if (slot->used >= cutoff && strmap_put(&nm, sh->map.keys[j], slot)) continue;
+                shmap_free_slot(m, slot);
+                dropped++;
+            }
+            strmap_free(&sh->map);
+            sh->map = nm;
+        }
+        pthread_mutex_unlock(&sh->lock);
+    }
+    return dropped;
+}
+
+/* ----------------- category variable cache for subcategory labels ----------------- */
+
+typedef struct ValueMap {
+    char *value_id;
+    char *label;
+    struct ValueMap *next;
+} ValueMap;
+
+typedef struct VarMap {
+    char *var_id;
+    char *var_name;
+    ValueMap *values;
+    struct VarMap *next;
+} VarMap;
+
+static ValueMap *valuemap_add(ValueMap *head, const char *id, const char *label) {
+    ValueMap *n = calloc(1, sizeof(ValueMap));
+    if (!n) return head;
+    n->value_id = strdup(id ? id : "");
+    n->label = strdup(label ? label : "");
+    n->next = head;
+    return n;
+}
+
+static VarMap *varmap_add(VarMap *head, const char *id, const char *name, ValueMap *values) {
+    VarMap *n = calloc(1, sizeof(VarMap));
+    if (!n) return head;
+    n->var_id = strdup(id ? id : "");
+    n->var_name = strdup(name ? name : "");
+    n->values = values;
+    n->next = head;
+    return n;
+}
+
+static void free_valuemap(ValueMap *v) {
+    while (v) {
+        ValueMap *nx = v->next;
+        free(v->value_id);
+        free(v->label);
+        free(v);
+        v = nx;
+    }
+}
+
+static void free_varmap(VarMap *v) {
+    while (v) {
+        VarMap *nx = v->next;
+        free(v->var_id);
+        free(v->var_name);
+        free_valuemap(v->values);
+        free(v);
+        v = nx;
+    }
+}
+
+static void free_varmap_val(void *v) {
+    free_varmap((VarMap *)v);
+}
+
+static const char *find_value_label(VarMap *vars, const char *var_id, const char *value_id, const char **var_name_out) {
+    for (VarMap *v = vars; v; v = v->next) {
+        if (strcmp(v->var_id, var_id) == 0) {
+            if (var_name_out) *var_name_out = v->var_name;
+            for (ValueMap *vm = v->values; vm; vm = vm->next) {
+                if (strcmp(vm->value_id, value_id) == 0) return vm->label;
+            }
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+static VarMap *load_category_vars(CURL *curl, const char *cat_id) {
+    LOG("Fetch category variables: cat_id=%s", cat_id ? cat_id : "(null)");
+
+    char url[512];
+    snprintf(url, sizeof(url),
+             "https://www.speedrun.com/api/v1/categories/%s/variables?max=200",
+             cat_id);
+
+    char *json = fetch_url(curl, url);
+    if (!json) return NULL;
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (!root) return NULL;
+
+    cJSON *data = cJSON_GetObjectItemCaseSensitive(root, "data");
+    if (!cJSON_IsArray(data)) { cJSON_Delete(root); return NULL; }
+
+    VarMap *vars = NULL;
+
+    cJSON *var = NULL;
+    cJSON_ArrayForEach(var, data) {
+        const char *var_id = json_get_string(var, "id");
+        const char *var_name = json_get_string(var, "name");
+        if (!var_id) continue;
+
+        ValueMap *values = NULL;
+
+        cJSON *valuesObj = cJSON_GetObjectItemCaseSensitive(var, "values");
+        cJSON *valuesValues = valuesObj ? cJSON_GetObjectItemCaseSensitive(valuesObj, "values") : NULL;
+
+        if (cJSON_IsObject(valuesValues)) {
+            cJSON *entry = NULL;
+            cJSON_ArrayForEach(entry, valuesValues) {
+                const char *value_id = entry->string;
+                const char *label = NULL;
+                if (cJSON_IsObject(entry)) label = json_get_string(entry, "label");
+                if (value_id) values = valuemap_add(values, value_id, label ? label : value_id);
+            }
+        }
+
+        vars = varmap_add(vars, var_id, var_name ? var_name : var_id, values);
+    }
+
+    cJSON_Delete(root);
+    return vars;
+}
+
+/* cat_id -> VarMap* (NULL cached too: a category whose variables failed to load) */
+static VarMap *get_cached_vars(CURL *curl, ShardMap *cache, const char *cat_id) {
+    void *cur;
+    if (shmap_get(cache, cat_id, &cur)) {
+        WR_PROBE(catvar_cache_hit, cat_id);
+        return (VarMap *)cur;
+    }
+    WR_PROBE(catvar_cache_miss, cat_id);
+
+    VarMap *vars = load_category_vars(curl, cat_id);
+    if (shmap_put(cache, cat_id, vars, &cur)) return vars;
+    free_varmap(vars);
+    return (VarMap *)cur;
+}
+
+static char *format_subcategories(CURL *curl, ShardMap *cache, const char *cat_id, cJSON *valuesObj) {
+    if (!cat_id || !cJSON_IsObject(valuesObj)) return strdup("");
+
+    VarMap *vars = get_cached_vars(curl, cache, cat_id);
+    if (!vars) return strdup("");
+
+    size_t cap = 256;
+    char *out = malloc(cap);
+    if (!out) return strdup("");
+    out[0] = '\0';
+    size_t used = 0;
+    int first = 1;
+
+    cJSON *kv = NULL;
+    cJSON_ArrayForEach(kv, valuesObj) {
+        if (!cJSON_IsString(kv) || !kv->valuestring || !kv->string) continue;
+
+        const char *var_name = NULL;
+        const char *val_label = find_value_label(vars, kv->string, kv->valuestring, &var_name);
+        if (!var_name) var_name = kv->string;
+        if (!val_label) val_label = kv->valuestring;
+
+        char chunk[512];
+        snprintf(chunk, sizeof(chunk), "%s%s: %s", first ? "" : ", ", var_name, val_label);
+        first = 0;
+
+        size_t clen = strlen(chunk);
+        if (used + clen + 1 > cap) {
+            while (used + clen + 1 > cap) cap *= 2;
+            char *tmp = realloc(out, cap);
+            if (!tmp) break;
+            out = tmp;
+        }
+        memcpy(out + used, chunk, clen);
+        used += clen;
+        out[used] = '\0';
+    }
+
+    return out;
+}
+
+/* ----------------- embedded id/name extraction ----------------- */
+
+static void extract_id_and_name(cJSON *field, const char **id_out, const char **name_out) {
+    *id_out = NULL;
+    *name_out = NULL;
+
+    if (cJSON_IsString(field)) {
+        *id_out = field->valuestring;
+        return;
+    }
+
+    if (cJSON_IsObject(field)) {
+        cJSON *data = cJSON_GetObjectItemCaseSensitive(field, "data");
+        if (cJSON_IsObject(data)) {
+            const char *id = json_get_string(data, "id");
+            if (id) *id_out = id;
+
+            cJSON *names = cJSON_GetObjectItemCaseSensitive(data, "names");
+            if (cJSON_IsObject(names)) {
+                const char *intl = json_get_string(names, "international");
+                if (intl) *name_out = intl;
+            }
+            const char *nm = json_get_string(data, "name");
+            if (nm) *name_out = nm;
+        }
+    }
+}
+
+/* Get game asset URI from an embedded run object (run.game.data.assets.<key>.uri) */
+static const char *get_game_asset_uri_from_run(cJSON *runObj, const char *asset_key) {
+    if (!cJSON_IsObject(runObj) || !asset_key) return NULL;
+
+    cJSON *game = cJSON_GetObjectItemCaseSensitive(runObj, "game");
+    if (!cJSON_IsObject(game)) return NULL;
+
+    cJSON *gdata = cJSON_GetObjectItemCaseSensitive(game, "data");
+    if (!cJSON_IsObject(gdata)) return NULL;
+
+    cJSON *assets = cJSON_GetObjectItemCaseSensitive(gdata, "assets");
+    if (!cJSON_IsObject(assets)) return NULL;
+
+    cJSON *asset = cJSON_GetObjectItemCaseSensitive(assets, asset_key);
+    if (!cJSON_IsObject(asset)) return NULL;
+
+    const char *uri = json_get_string(asset, "uri");
+    return (uri && uri[0]) ? uri : NULL;
+}
+
+/* Normalize cover URLs:
+   - force https
+   - change ".../cover?..." to ".../cover.png?..." (or ".../cover.png" if no query)
+*/
+static void normalize_cover_uri(const char *in, char *out, size_t outsz) {
+    if (!out || outsz == 0) return;
+    out[0] = '\0';
+    if (!in || !in[0]) return;
+
+    char tmp[1024];
+    tmp[0] = '\0';
+
+    if (strncmp(in, "http://", 7) == 0) {
+        snprintf(tmp, sizeof(tmp), "https://%s", in + 7);
+    } else {
+        snprintf(tmp, sizeof(tmp), "%s", in);
+    }
+
+    const char *p = g_isa->find(tmp, strlen(tmp), "/cover", 6);
+    if (!p) {
+        snprintf(out, outsz, "%s", tmp);
+        return;
+    }
+
+    if (strncmp(p, "/cover.png", 9) == 0) {
+        snprintf(out, outsz, "%s", tmp);
+        return;
+    }
+
+    size_t prefix_len = (size_t)(p - tmp) + strlen("/cover");
+    if (prefix_len >= sizeof(tmp)) {
+        snprintf(out, outsz, "%s", tmp);
+        return;
+    }
+
+    char prefix[1024];
+    if (prefix_len >= sizeof(prefix)) {
+        snprintf(out, outsz, "%s", tmp);
+        return;
+    }
+    memcpy(prefix, tmp, prefix_len);
+    prefix[prefix_len] = '\0';
+
+    const char *suffix = tmp + prefix_len;
+    snprintf(out, outsz, "%s.png%s", prefix, suffix);
+}
+
+/* The smallest cover asset of the run's embedded game, normalized; "" if none. */
+static void run_cover_uri(cJSON *runObj, char *out, size_t outsz) {
+    static const char *keys[] = { "cover-tiny", "cover-small", "cover-medium", "cover-large", "icon" };
+    const char *uri = NULL;
+    for (size_t i = 0; !uri && i < sizeof(keys) / sizeof(keys[0]); i++)
+        uri = get_game_asset_uri_from_run(runObj, keys[i]);
+    out[0] = '\0';
+    if (uri) normalize_cover_uri(uri, out, outsz);
+}
+
+/* Normalize any URI:
+   - force https if it starts with http://
+*/
+static void normalize_uri_https(const char *in, char *out, size_t outsz) {
+    if (!out || outsz == 0) return;
+    out[0] = '\0';
+    if (!in || !in[0]) return;
+
+    if (strncmp(in, "http://", 7) == 0) {
+        snprintf(out, outsz, "https://%s", in + 7);
+    } else {
+        snprintf(out, outsz, "%s", in);
+    }
+}
+
+/* Normalize speedrun.com user image URLs:
+   - force https
+   - change ".../image?..." to ".../image.png?..." (or ".../image.png" if no query)
+   Examples:
+     https://www.speedrun.com/static/user/abc/image?v=123  -> https://www.speedrun.com/static/user/abc/image.png?v=123
+     http://www.speedrun.com/static/user/abc/image         -> https://www.speedrun.com/static/user/abc/image.png
+*/
+static void normalize_user_image_uri(const char *in, char *out, size_t outsz) {
+    if (!out || outsz == 0) return;
+    out[0] = '\0';
+    if (!in || !in[0]) return;
+
+    char tmp[1024];
+    tmp[0] = '\0';
+
+    /* https */
+    if (strncmp(in, "http://", 7) == 0) {
+        snprintf(tmp, sizeof(tmp), "https://%s", in + 7);
+    } else {
+        snprintf(tmp, sizeof(tmp), "%s", in);
+    }
+
+    /* find last "/image" occurrence */
+    const char *p = NULL;
+    const char *q = tmp;
+    const char *end = tmp + strlen(tmp);
+    while ((q = g_isa->find(q, (size_t)(end - q), "/image", 6)) != NULL) {
+        p = q;
+        q += 6; /* strlen("/image") */
+    }
+
+    if (!p) {
+        snprintf(out, outsz, "%s", tmp);
+        return;
+    }
+
+    /* already has .png */
+    if (strncmp(p, "/image.png", 10) == 0) {
+        snprintf(out, outsz, "%s", tmp);
+        return;
+    }
+
+    /* only rewrite if it's exactly "/image" followed by end or query/fragment */
+    if (strncmp(p, "/image", 6) == 0) {
+        char after = p[6];
+        if (after == '\0' || after == '?' || after == '#') {
+            size_t prelen = (size_t)(p - tmp) + 6; /* include "/image" */
+            if (prelen >= sizeof(tmp)) {
+                snprintf(out, outsz, "%s", tmp);
+                return;
+            }
+
+            /* out = tmp[0:prelen] + ".png" + tmp[prelen:] */
+            /* tmp[prelen:] starts at '?' or '\0' or '#' */
+            int written = snprintf(out, outsz, "%.*s.png%s", (int)prelen, tmp, tmp + prelen);
+            if (written < 0) out[0] = '\0';
+            return;
+        }
+    }
+
+    snprintf(out, outsz, "%s", tmp);
+}
+
+static void print_players_compact(cJSON *runObj, char *out, size_t outsz) {
+    out[0] = '\0';
+    cJSON *players = cJSON_GetObjectItemCaseSensitive(runObj, "players");
+    if (cJSON_IsObject(players)) players = cJSON_GetObjectItemCaseSensitive(players, "data");
+    if (!cJSON_IsArray(players)) return;
+
+    size_t used = 0;
+    int first = 1;
+
+    cJSON *p = NULL;
+    cJSON_ArrayForEach(p, players) {
+        const char *name = json_get_string(p, "name");
+        if (!name) {
+            cJSON *names = cJSON_GetObjectItemCaseSensitive(p, "names");
+            if (cJSON_IsObject(names)) name = json_get_string(names, "international");
+        }
+        if (!name) name = json_get_string(p, "id");
+        if (!name) name = "unknown";
+
+        char chunk[256];
+        snprintf(chunk, sizeof(chunk), "%s%s", first ? "" : ", ", name);
+        first = 0;
+
+        size_t clen = strlen(chunk);
+        if (used + clen + 1 >= outsz) break;
+        memcpy(out + used, chunk, clen);
+        used += clen;
+        out[used] = '\0';
+    }
+}
+
+/* Build players array with avatar + profile link from embedded run.players.data */
+static cJSON *build_players_array(cJSON *runObj) {
+    cJSON *players = cJSON_GetObjectItemCaseSensitive(runObj, "players");
+    if (cJSON_IsObject(players)) players = cJSON_GetObjectItemCaseSensitive(players, "data");
+    if (!cJSON_IsArray(players)) return NULL;
+
+    cJSON *out = cJSON_CreateArray();
+    if (!out) return NULL;
+
+    cJSON *p = NULL;
+    cJSON_ArrayForEach(p, players) {
+        const char *name = json_get_string(p, "name");
+        if (!name) {
+            cJSON *names = cJSON_GetObjectItemCaseSensitive(p, "names");
+            if (cJSON_IsObject(names)) name = json_get_string(names, "international");
+        }
+        if (!name) name = json_get_string(p, "id");
+        if (!name) name = "unknown";
+
+        const char *weblink = json_get_string(p, "weblink");
+
+        const char *img_raw = NULL;
+        cJSON *assets = cJSON_GetObjectItemCaseSensitive(p, "assets");
+        if (cJSON_IsObject(assets)) {
+            cJSON *imgObj = cJSON_GetObjectItemCaseSensitive(assets, "image");
+            if (cJSON_IsObject(imgObj)) img_raw = json_get_string(imgObj, "uri");
+
+            if (!img_raw || !img_raw[0]) {
+                cJSON *iconObj = cJSON_GetObjectItemCaseSensitive(assets, "icon");
+                if (cJSON_IsObject(iconObj)) img_raw = json_get_string(iconObj, "uri");
+            }
+        }
+
+        char img[1024];
+        img[0] = '\0';
+        if (img_raw && img_raw[0]) {
+            /* IMPORTANT: user avatars require ".png" inserted after "/image" */
+            normalize_user_image_uri(img_raw, img, sizeof(img));
+        }
+
+        cJSON *o = cJSON_CreateObject();
+        cJSON_AddStringToObject(o, "name", name);
+        cJSON_AddStringToObject(o, "weblink", (weblink && weblink[0]) ? weblink : "");
+        cJSON_AddStringToObject(o, "image", img[0] ? img : "");
+        cJSON_AddItemToArray(out, o);
+    }
+
+    if (cJSON_GetArraySize(out) == 0) {
+        cJSON_Delete(out);
+        return NULL;
+    }
+
+    return out;
+}
+
+/* ----------------- leaderboard top-1 cache (in-memory) ----------------- */
+
+/* lb key -> top run id; lives for one scan (see wrd_update) */
+static void build_leaderboard_url_top(char *out, size_t outsz,
+                                     const char *gameId, const char *categoryId, const char *levelId,
+                                     cJSON *valuesObj, int topN) {
+    if (outsz == 0) return;
+    out[0] = '\0';
+
+    int written = 0;
+    if (levelId && levelId[0]) {
+        written = snprintf(out, outsz,
+                           "https://www.speedrun.com/api/v1/leaderboards/%s/level/%s/%s?top=%d",
+                           gameId, levelId, categoryId, topN);
+    } else {
+        written = snprintf(out, outsz,
+                           "https://www.speedrun.com/api/v1/leaderboards/%s/category/%s?top=%d",
+                           gameId, categoryId, topN);
+    }
+    if (written < 0 || (size_t)written >= outsz) { out[outsz - 1] = '\0'; return; }
+
+    size_t used = (size_t)written;
+
+    if (cJSON_IsObject(valuesObj)) {
+        cJSON *kv = NULL;
+        cJSON_ArrayForEach(kv, valuesObj) {
+            if (!cJSON_IsString(kv) || !kv->valuestring || !kv->string) continue;
+
+            int add = snprintf(out + used, outsz - used, "&var-%s=%s", kv->string, kv->valuestring);
+            if (add < 0) break;
+            if ((size_t)add >= outsz - used) { out[outsz - 1] = '\0'; break; }
+            used += (size_t)add;
+        }
+    }
+}
+
+typedef struct KVPair { const char *k; const char *v; } KVPair;
+
+static int kv_cmp(const void *a, const void *b) {
+    const KVPair *ka = (const KVPair*)a;
+    const KVPair *kb = (const KVPair*)b;
+    return strcmp(ka->k, kb->k);
+}
+
+static char *make_lb_key(const char *gameId, const char *catId, const char *levelId, cJSON *valuesObj) {
+    size_t cap = 2048;
+    char *buf = malloc(cap);
+    if (!buf) return NULL;
+
+    snprintf(buf, cap, "%s|%s|%s|", gameId ? gameId : "", catId ? catId : "", levelId ? levelId : "");
+
+    int n = 0;
+    if (cJSON_IsObject(valuesObj)) {
+        cJSON *kv = NULL;
+        cJSON_ArrayForEach(kv, valuesObj) {
+            if (kv->string && cJSON_IsString(kv) && kv->valuestring) n++;
+        }
+    }
+
+    KVPair *pairs = NULL;
+    if (n > 0) {
+        pairs = calloc((size_t)n, sizeof(KVPair));
+        if (!pairs) { free(buf); return NULL; }
+
+        int i = 0;
+        cJSON *kv = NULL;
+        cJSON_ArrayForEach(kv, valuesObj) {
+            if (kv->string && cJSON_IsString(kv) && kv->valuestring) {
+                pairs[i].k = kv->string;
+                pairs[i].v = kv->valuestring;
+                i++;
+            }
+        }
+        qsort(pairs, (size_t)n, sizeof(KVPair), kv_cmp);
+    }
+
+    size_t used = strlen(buf);
+    for (int i = 0; i < n; i++) {
+        char chunk[256];
+        snprintf(chunk, sizeof(chunk), "%s=%s&", pairs[i].k, pairs[i].v);
+        size_t clen = strlen(chunk);
+        if (used + clen + 1 > cap) {
+            while (used + clen + 1 > cap) cap *= 2;
+            char *tmp = realloc(buf, cap);
+            if (!tmp) break;
+            buf = tmp;
+        }
+        memcpy(buf + used, chunk, clen);
+        used += clen;
+        buf[used] = '\0';
+    }
+
+    free(pairs);
+    return buf;
+}
+
+static const char *lb_cache_get(ShardMap *cache, const char *key) {
+    void *top;
+    if (shmap_get(cache, key, &top)) {
+        WR_PROBE(lb_cache_hit, key);
+        return (const char *)top;
+    }
+    WR_PROBE(lb_cache_miss, key);
+    return NULL;
+}
+
+/* returns the cached copy of top_run_id (another worker's, if it got there first) */
+static const char *lb_cache_put(ShardMap *cache, const char *key, const char *top_run_id) {
+    char *top = strdup(top_run_id ? top_run_id : "");
+    void *cur;
+    if (!top) return NULL;
+    if (shmap_put(cache, key, top, &cur)) return top;
+    free(top);
+    return (const char *)cur;
+}
+
+/*
+   Keys being fetched right now: a --jobs worker that misses a key another worker is
+   already asking for waits for that answer instead of sending the same request.
+*/
+typedef struct LbFlight {
+    char *key;
+    int done;
+    int waiters;
+    struct LbFlight *next;
+} LbFlight;
+
+static pthread_mutex_t g_lb_flight_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_lb_flight_cond = PTHREAD_COND_INITIALIZER;
+static LbFlight *g_lb_flights = NULL;
+static LbFlight g_lb_untracked;   /* no memory for a flight: fetch without telling anyone */
+
+/* The caller's flight for key (it fetches, then lb_flight_end), or NULL once another
+   worker's fetch of key has finished (look in the cache again). */
+static LbFlight *lb_flight_begin(const char *key) {
+    pthread_mutex_lock(&g_lb_flight_lock);
+    LbFlight *fl = g_lb_flights;
+    while (fl && strcmp(fl->key, key) != 0) fl = fl->next;
+    if (fl) {
+        fl->waiters++;
+        while (!fl->done) pthread_cond_wait(&g_lb_flight_cond, &g_lb_flight_lock);
+        if (--fl->waiters == 0) { free(fl->key); free(fl); }
+        pthread_mutex_unlock(&g_lb_flight_lock);
+        return NULL;
+    }
+    fl = (LbFlight *)calloc(1, sizeof(LbFlight));
+    if (fl && !(fl->key = strdup(key))) { free(fl); fl = NULL; }
+    if (fl) {
+        fl->next = g_lb_flights;
+        g_lb_flights = fl;
+    }
+    pthread_mutex_unlock(&g_lb_flight_lock);
+    return fl ? fl : &g_lb_untracked;
+}
+
+static void lb_flight_end(LbFlight *fl) {
+    if (fl == &g_lb_untracked) return;
+    pthread_mutex_lock(&g_lb_flight_lock);
+    for (LbFlight **pp = &g_lb_flights; *pp; pp = &(*pp)->next) {
+        if (*pp == fl) { *pp = fl->next; break; }
+    }
+    fl->done = 1;
+    pthread_cond_broadcast(&g_lb_flight_cond);
+    if (fl->waiters == 0) { free(fl->key); free(fl); }
+    pthread_mutex_unlock(&g_lb_flight_lock);
+}
+
+static const char *fetch_top1_run_id(CURL *curl,
+                                     ShardMap *cache,
+                                     const char *gameId,
+                                     const char *catId,
+                                     const char *levelId,
+                                     cJSON *valuesObj) {
+    char *key = make_lb_key(gameId, catId, levelId, valuesObj);
+    if (!key) return NULL;
+
+    /* after waiting on another worker's fetch, its answer is in the cache (or it
+       failed, and this worker asks again as it would have alone) */
+    LbFlight *fl;
+    do {
+        const char *cached = lb_cache_get(cache, key);
+        if (cached) {
+            free(key);
+            return cached;
+        }
+    } while ((fl = lb_flight_begin(key)) == NULL);
+
+    char url[2048];
+    build_leaderboard_url_top(url, sizeof(url), gameId, catId, levelId, valuesObj, 1);
+
+    const char *ret = NULL;
+    char *json = fetch_url(curl, url);
+    cJSON *root = json ? cJSON_Parse(json) : NULL;
+    free(json);
+
+    const char *topId = NULL;
+    cJSON *data = cJSON_GetObjectItemCaseSensitive(root, "data");
+    cJSON *runs = data ? cJSON_GetObjectItemCaseSensitive(data, "runs") : NULL;
+    if (cJSON_IsArray(runs) && cJSON_GetArraySize(runs) > 0) {
+        cJSON *first = cJSON_GetArrayItem(runs, 0);
+        cJSON *runObj = first ? cJSON_GetObjectItemCaseSensitive(first, "run") : NULL;
+        if (cJSON_IsObject(runObj)) topId = json_get_string(runObj, "id");
+    }
+    if (topId) ret = lb_cache_put(cache, key, topId);
+
+    lb_flight_end(fl);
+    cJSON_Delete(root);
+    free(key);
+    return ret;
+}
+
+static int is_current_wr(CURL *curl, ShardMap *cache,
+                         const char *runId,
+                         const char *gameId,
+                         const char *catId,
+                         const char *levelId,
+                         cJSON *valuesObj) {
+    const char *topId = fetch_top1_run_id(curl, cache, gameId, catId, levelId, valuesObj);
+    if (!topId || !runId) return 0;
+    return strcmp(topId, runId) == 0;
+}
+
+/* ----------------- persistence ----------------- */
+
+static long load_last_seen_epoch(void) {
+    char *txt = read_file("data/state.json");
+    if (!txt) return 0;
+    cJSON *root = cJSON_Parse(txt);
+    free(txt);
+    if (!root) return 0;
+    long v = json_get_long(root, "last_seen_epoch", 0);
+    cJSON_Delete(root);
+    if (v < 0) v = 0;
+    return v;
+}
+
+static void save_last_seen_epoch(long last_seen_epoch) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "last_seen_epoch", (double)last_seen_epoch);
+
+    char *out = cJSON_Print(root);
+    cJSON_Delete(root);
+    if (!out) return;
+
+    write_file_last("data/state.json", out);
+    free(out);
+}
+
+/* ----------------- change log (data/changes.jsonl) ----------------- */
+
+/*
+   Every mutation of the WR list gets the next sequence number and one line in
+   data/changes.jsonl:
+     {"seq":41,"at":1784919600,"op":"insert","run_id":"...","row":{...}}
+   op is insert (new row), enrich (players_data added; row is the updated row) or
+   prune (row dropped out of the 24h window; no row). seq and at come first on
+   every line and both only grow, so readers binary-search the file instead of
+   parsing it. Events older than CHANGES_KEEP_SEC are trimmed when new ones are
+   appended; a consumer whose cursor predates the oldest kept event must resync
+   from the store.
+*/
+#include <limits.h>
+
+#define CHANGES_PATH "data/changes.jsonl"
+#define CHANGES_KEEP_SEC (7 * 24 * 3600)
+
+typedef struct {
+    long next_seq;
+    time_t now;
+    char *existing;   /* file content at startup */
+    Buffer pending;   /* events of this run, JSONL */
+    int events;
+} ChangeLog;
+
+static ChangeLog g_changes = { .next_seq = 1 };
+
+/* value of "key": on the line starting at txt[pos]; LONG_MIN if missing */
+static long change_line_field(const char *txt, size_t len, size_t pos, const char *key) {
+    const char *end = memchr(txt + pos, '\n', len - pos);
+    size_t n = end ? (size_t)(end - (txt + pos)) : len - pos;
+    char pat[32];
+    int pn = snprintf(pat, sizeof(pat), "\"%s\":", key);
+    const char *hit = memmem(txt + pos, n, pat, (size_t)pn);
+    if (!hit) return LONG_MIN;
+    return strtol(hit + pn, NULL, 10);
+}
+
+static size_t change_next_line(const char *txt, size_t len, size_t pos) {
+    const char *nl = memchr(txt + pos, '\n', len - pos);
+    return nl ? (size_t)(nl - txt) + 1 : len;
+}
+
+/* Byte offset of the first line whose `key` is >= target (len if none). */
+static size_t change_lower_bound(const char *txt, size_t len, const char *key, long target) {
+    size_t lo = 0, hi = len; /* lo is always a line start */
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t s = mid == lo ? lo : change_next_line(txt, len, mid - 1);
+        if (s >= hi) s = lo; /* no line starts in [mid, hi): probe lo itself */
+        if (change_line_field(txt, len, s, key) >= target) hi = s;
+        else lo = change_next_line(txt, len, s);
+    }
+    return lo;
+}
+
+static void changes_open(time_t now) {
+    g_changes.now = now;
+    g_changes.existing = read_file(CHANGES_PATH);
+    const char *txt = g_changes.existing;
+    if (!txt) return;
+
+    /* seq of the last line + 1 */
+    size_t len = strlen(txt);
+    size_t end = len;
+    while (end > 0 && txt[end - 1] == '\n') end--;
+    size_t start = end;
+    while (start > 0 && txt[start - 1] != '\n') start--;
+    if (start < end) {
+        long last = change_line_field(txt, len, start, "seq");
+        if (last != LONG_MIN) g_changes.next_seq = last + 1;
+    }
+}
+
+static void changes_record(const char *op, const char *run_id, cJSON *row) {
+    cJSON *ev = cJSON_CreateObject();
+    if (!ev) return;
+    cJSON_AddNumberToObject(ev, "seq", (double)g_changes.next_seq);
+    cJSON_AddNumberToObject(ev, "at", (double)g_changes.now);
+    cJSON_AddStringToObject(ev, "op", op);
+    cJSON_AddStringToObject(ev, "run_id", run_id ? run_id : "");
+    if (row) cJSON_AddItemToObject(ev, "row", cJSON_Duplicate(row, 1));
+
+    char *line = cJSON_PrintUnformatted(ev);
+    cJSON_Delete(ev);
+    if (!line) return;
+    buf_append(&g_changes.pending, line, strlen(line));
+    buf_append(&g_changes.pending, "\n", 1);
+    free(line);
+    g_changes.next_seq++;
+    g_changes.events++;
+}
+
+/* Append this run's events and trim expired ones; untouched when nothing changed. */
+static void changes_save(void) {
+    if (g_changes.events > 0) {
+        Buffer b = {0};
+        const char *old = g_changes.existing;
+        if (old) {
+            size_t len = strlen(old);
+            size_t keep = change_lower_bound(old, len, "at", (long)g_changes.now - CHANGES_KEEP_SEC);
+            buf_append(&b, old + keep, len - keep);
+        }
+        buf_append(&b, g_changes.pending.data, g_changes.pending.size);
+        if (!b.data || !write_file(CHANGES_PATH, b.data)) LOG("Changes: failed to write %s", CHANGES_PATH);
+        else LOG("Changes: %d event(s), next seq=%ld", g_changes.events, g_changes.next_seq);
+        free(b.data);
+    }
+    free(g_changes.existing);
+    free(g_changes.pending.data);
+    memset(&g_changes.pending, 0, sizeof(g_changes.pending));
+    g_changes.existing = NULL;
+    g_changes.events = 0;
+}
+
+/*
+   wr_daily changes --since SEQ   events with seq > SEQ, as stored (JSONL)
+   wr_daily changes --head        the latest seq (cursor to use after a full read)
+   Exit status 3 means SEQ is older than the retained log: resync from the store.
+   The file is mapped, so only the pages around the cursor are actually read.
+*/
+static const char *changes_map(size_t *len, void **map) {
+    const char *txt = "";
+    *len = 0;
+    *map = NULL;
+    int fd = open(CHANGES_PATH, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (*map != MAP_FAILED) { txt = *map; *len = (size_t)st.st_size; }
+        else *map = NULL;
+    }
+    if (fd >= 0) close(fd);
+    return txt;
+}
+
+long long wrd_changes_head(void) {
+    size_t len;
+    void *map;
+    const char *txt = changes_map(&len, &map);
+    size_t end = len;
+    while (end > 0 && txt[end - 1] == '\n') end--;
+    size_t start = end;
+    while (start > 0 && txt[start - 1] != '\n') start--;
+    long last = start < end ? change_line_field(txt, len, start, "seq") : 0;
+    if (map) munmap(map, len);
+    return last == LONG_MIN ? 0 : last;
+}
+
+int wrd_changes_since(long long since, FILE *out) {
+    size_t len;
+    void *map;
+    const char *txt = changes_map(&len, &map);
+
+    int rc = WRD_OK;
+    long first = len ? change_line_field(txt, len, 0, "seq") : LONG_MIN;
+    if (first != LONG_MIN && first > since + 1) {
+        fprintf(stderr, "cursor %lld predates the change log (oldest seq %ld); resync from the store\n",
+                since, first);
+        rc = WRD_ESTALE;
+    } else {
+        size_t from = change_lower_bound(txt, len, "seq", (long)since + 1);
+        if (from < len && fwrite(txt + from, 1, len - from, out) != len - from) rc = WRD_ERR;
+    }
+
+    if (map) munmap(map, len);
+    return rc;
+}
+
+/* ----------------- raw run slices (--store-raw) ----------------- */
+
+/*
+   With --store-raw each accepted WR keeps the bytes of its run object exactly as the
+   API sent them, next to the extracted fields: the "data" value of the run-details
+   body is cut out by byte range (no re-print), deflated and stored base64 as "raw"
+   (4-byte little-endian length, then the zlib stream). Nothing on the hot path reads
+   it; store saves and the change log pass the string through untouched, and
+   wrd_wr_raw_json() inflates it only for callers that ask. The store reads it back
+   in one case: a fact whose game, category or player rows were lost is rebuilt from
+   its slice (raw_rebuild_row) instead of being refetched by a feed recheck.
+*/
+static int g_store_raw = 0;
+
+static const char k_b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static char *b64_encode(const unsigned char *in, size_t n) {
+    char *out = malloc((n + 2) / 3 * 4 + 1);
+    if (!out) return NULL;
+    char *o = out;
+    for (size_t i = 0; i < n; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < n) v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < n) v |= in[i + 2];
+        *o++ = k_b64[v >> 18 & 63];
+        *o++ = k_b64[v >> 12 & 63];
+        *o++ = i + 1 < n ? k_b64[v >> 6 & 63] : '=';
+        *o++ = i + 2 < n ? k_b64[v & 63] : '=';
+    }
+    *o = '\0';
+    return out;
+}
+
+static unsigned char *b64_decode(const char *in, size_t *n_out) {
+    size_t n = strlen(in);
+    if (n % 4) return NULL;
+    unsigned char *out = malloc(n / 4 * 3 + 1);
+    if (!out) return NULL;
+    size_t o = 0;
+    for (size_t i = 0; i < n; i += 4) {
+        uint32_t v = 0;
+        int pad = 0;
+        for (int k = 0; k < 4; k++) {
+            const char *p = in[i + k] == '=' ? NULL : strchr(k_b64, in[i + k]);
+            if (in[i + k] == '=') pad++;
+            else if (!p || !in[i + k] || pad) { free(out); return NULL; }
+            v = v << 6 | (uint32_t)(p ? p - k_b64 : 0);
+        }
+        if (pad > 2) { free(out); return NULL; }
+        out[o++] = (unsigned char)(v >> 16);
+        if (pad < 2) out[o++] = (unsigned char)(v >> 8);
+        if (pad < 1) out[o++] = (unsigned char)v;
+    }
+    *n_out = o;
+    return out;
+}
+
+/* End of the JSON value starting at p (NULL if it runs past end). */
+static const char *json_value_end(const char *p, const char *end) {
+    int depth = 0;
+    while (p < end) {
+        char c = *p++;
+        if (c == '"') {
+            while (p < end && *p != '"') p += *p == '\\' ? 2 : 1;
+            if (p >= end) return NULL;
+            p++;
+            if (depth == 0) return p;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (--depth < 0) return p - 1;
+            if (depth == 0) return p;
+        } else if (depth == 0 && (c == ',' || c == ' ' || c == '\n' || c == '\r' || c == '\t')) {
+            return p - 1;
+        }
+    }
+    return depth == 0 ? end : NULL;
+}
+
+/* Byte range of the top-level "data" value of a response body. */
+static int json_data_slice(const char *body, const char **start, size_t *len) {
+    const char *end = body + strlen(body);
+    const char *p = body;
+    while (p < end && *p != '{') p++;
+    for (p++; p < end; ) {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t' || *p == ',')) p++;
+        if (p >= end || *p != '"') return 0;
+        const char *key = p + 1;
+        const char *kend = json_value_end(p, end);
+        if (!kend) return 0;
+        p = kend;
+        while (p < end && *p != ':') p++;
+        for (p++; p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'); p++) {}
+        const char *vend = json_value_end(p, end);
+        if (!vend) return 0;
+        if (kend - key == 5 && memcmp(key, "data\"", 5) == 0) {
+            *start = p;
+            *len = (size_t)(vend - p);
+            return 1;
+        }
+        p = vend;
+    }
+    return 0;
+}
+
+/* The packed "raw" field for a slice, or NULL. */
+static char *raw_pack(const char *slice, size_t len) {
+    if (len > UINT32_MAX) return NULL;
+    uLongf zlen = compressBound((uLong)len);
+    unsigned char *buf = malloc(4 + zlen);
+    if (!buf) return NULL;
+    buf[0] = (unsigned char)len;
+    buf[1] = (unsigned char)(len >> 8);
+    buf[2] = (unsigned char)(len >> 16);
+    buf[3] = (unsigned char)(len >> 24);
+    char *out = NULL;
+    if (compress2(buf + 4, &zlen, (const Bytef *)slice, (uLong)len, Z_BEST_COMPRESSION) == Z_OK)
+        out = b64_encode(buf, 4 + zlen);
+    free(buf);
+    return out;
+}
+
+static char *raw_unpack(const char *raw, size_t *len_out) {
+    size_t n = 0;
+    unsigned char *buf = raw ? b64_decode(raw, &n) : NULL;
+    if (!buf || n < 4) { free(buf); return NULL; }
+    uLongf len = (uLongf)buf[0] | (uLongf)buf[1] << 8 | (uLongf)buf[2] << 16 | (uLongf)buf[3] << 24;
+    char *out = malloc(len + 1);
+    if (out && uncompress((Bytef *)out, &len, buf + 4, (uLong)(n - 4)) != Z_OK) { free(out); out = NULL; }
+    free(buf);
+    if (!out) return NULL;
+    out[len] = '\0';
+    if (len_out) *len_out = len;
+    return out;
+}
+
+/*
+   The flat row for store fact f, with the game, category and players taken from its
+   raw slice; NULL if f has no slice or the slice lacks them. The slice is the embedded
+   run add_wr_entry_from_run() built the row from, so the result is the same row.
+*/
+static cJSON *raw_rebuild_row(cJSON *f) {
+    char *txt = raw_unpack(json_get_string(f, "raw"), NULL);
+    cJSON *run = txt ? cJSON_Parse(txt) : NULL;
+    free(txt);
+
+    const char *gameId = NULL, *gameName = NULL;
+    const char *catId = NULL, *catName = NULL;
+    const char *levelId = NULL, *levelName = NULL;
+    extract_id_and_name(cJSON_GetObjectItemCaseSensitive(run, "game"), &gameId, &gameName);
+    extract_id_and_name(cJSON_GetObjectItemCaseSensitive(run, "category"), &catId, &catName);
+    extract_id_and_name(cJSON_GetObjectItemCaseSensitive(run, "level"), &levelId, &levelName);
+    const char *runId = json_get_string(f, "run_id");
+    if (!runId || !gameId || !catId) { cJSON_Delete(run); return NULL; }
+
+    char cover[1024], players[512];
+    run_cover_uri(run, cover, sizeof(cover));
+    print_players_compact(run, players, sizeof(players));
+    cJSON *players_data = build_players_array(run);
+
+    const char *iso = json_get_string(f, "verified_iso");
+    const char *sub = json_get_string(f, "subcats");
+    const char *link = json_get_string(f, "weblink");
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddStringToObject(obj, "run_id", runId);
+    cJSON_AddNumberToObject(obj, "verified_epoch", (double)json_get_long(f, "verified_epoch", 0));
+    cJSON_AddStringToObject(obj, "verified_iso", iso ? iso : "");
+    cJSON_AddStringToObject(obj, "game", gameName ? gameName : gameId);
+    cJSON_AddStringToObject(obj, "game_cover", cover);
+    cJSON_AddStringToObject(obj, "category", catName ? catName : catId);
+    cJSON_AddStringToObject(obj, "level", levelId ? (levelName ? levelName : levelId) : "");
+    cJSON_AddStringToObject(obj, "subcats", sub ? sub : "");
+    cJSON_AddNumberToObject(obj, "primary_t", json_get_number(f, "primary_t", -1));
+    cJSON_AddStringToObject(obj, "players", players);
+    if (players_data) cJSON_AddItemToObject(obj, "players_data", players_data);
+    cJSON_AddStringToObject(obj, "weblink", link ? link : "");
+    cJSON_AddStringToObject(obj, "raw", json_get_string(f, "raw"));
+    cJSON_Delete(run);
+    return obj;
+}
+
+/* ----------------- normalized store (WR facts + game/category/player dimensions) ----------------- */
+
+/*
+   data/wrs.json (schema 2):
+     {
+       "schema": 2,
+       "games":      [{ "id", "name", "cover" }],
+       "categories": [{ "id", "category", "level" }],
+       "players":    [{ "id", "name", "weblink", "image" }],
+       "wrs":        [{ "run_id", "verified_epoch", "verified_iso", "game", "category",
+                        "subcats", "primary_t", "players" (ids) or "players_text", "weblink",
+                        "raw" (--store-raw only) }]
+     }
+   Dimension ids are a hash of the row content, so repeated strings collapse into one
+   row and ids stay stable from run to run. In memory we keep working on flat rows:
+   store_join() rebuilds them on load and store_normalize() splits them on save.
+   A legacy flat array in wrs.json is still accepted and rewritten on the next save.
+*/
+
+#define WR_STORE_SCHEMA 2
+
+/* id = hex(fnv1a_64(a \x1f b \x1f c)) */
+static void make_dim_id(char out[17], const char *a, const char *b, const char *c) {
+    uint64_t h = 1469598103934665603ULL;
+    h = fnv1a_64_update(h, a);
+    h = fnv1a_64_update(h, "\x1f");
+    h = fnv1a_64_update(h, b);
+    h = fnv1a_64_update(h, "\x1f");
+    h = fnv1a_64_update(h, c);
+    snprintf(out, 17, "%016llx", (unsigned long long)h);
+}
+
+static cJSON *store_normalize(cJSON *rows) {
+    cJSON *doc = cJSON_CreateObject();
+    if (!doc) return NULL;
+    cJSON_AddNumberToObject(doc, "schema", WR_STORE_SCHEMA);
+    cJSON *games = cJSON_AddArrayToObject(doc, "games");
+    cJSON *cats = cJSON_AddArrayToObject(doc, "categories");
+    cJSON *players = cJSON_AddArrayToObject(doc, "players");
+    cJSON *facts = cJSON_AddArrayToObject(doc, "wrs");
+    if (!games || !cats || !players || !facts) { cJSON_Delete(doc); return NULL; }
+
+    StrSet seenGames = {0}, seenCats = {0}, seenPlayers = {0};
+    strset_init(&seenGames, 256);
+    strset_init(&seenCats, 512);
+    strset_init(&seenPlayers, 1024);
+
+    cJSON *it = NULL;
+    cJSON_ArrayForEach(it, rows) {
+        if (!cJSON_IsObject(it)) continue;
+
+        const char *runId = json_get_string(it, "run_id");
+        if (!runId) continue;
+
+        const char *game = json_get_string(it, "game");
+        const char *cover = json_get_string(it, "game_cover");
+        const char *cat = json_get_string(it, "category");
+        const char *lvl = json_get_string(it, "level");
+        if (!game) game = "";
+        if (!cover) cover = "";
+        if (!cat) cat = "";
+        if (!lvl) lvl = "";
+
+        char gid[17], cid[17];
+        make_dim_id(gid, game, cover, NULL);
+        make_dim_id(cid, cat, lvl, NULL);
+
+        if (!strset_has(&seenGames, gid)) {
+            cJSON *g = cJSON_CreateObject();
+            cJSON_AddStringToObject(g, "id", gid);
+            cJSON_AddStringToObject(g, "name", game);
+            cJSON_AddStringToObject(g, "cover", cover);
+            cJSON_AddItemToArray(games, g);
+            strset_add(&seenGames, gid);
+        }
+        if (!strset_has(&seenCats, cid)) {
+            cJSON *c = cJSON_CreateObject();
+            cJSON_AddStringToObject(c, "id", cid);
+            cJSON_AddStringToObject(c, "category", cat);
+            cJSON_AddStringToObject(c, "level", lvl);
+            cJSON_AddItemToArray(cats, c);
+            strset_add(&seenCats, cid);
+        }
+
+        const char *sub = json_get_string(it, "subcats");
+        const char *iso = json_get_string(it, "verified_iso");
+        const char *link = json_get_string(it, "weblink");
+
+        cJSON *f = cJSON_CreateObject();
+        cJSON_AddStringToObject(f, "run_id", runId);
+        cJSON_AddNumberToObject(f, "verified_epoch", (double)json_get_long(it, "verified_epoch", 0));
+        cJSON_AddStringToObject(f, "verified_iso", iso ? iso : "");
+        cJSON_AddStringToObject(f, "game", gid);
+        cJSON_AddStringToObject(f, "category", cid);
+        cJSON_AddStringToObject(f, "subcats", sub ? sub : "");
+        cJSON_AddNumberToObject(f, "primary_t", json_get_number(it, "primary_t", -1));
+
+        cJSON *pdata = cJSON_GetObjectItemCaseSensitive(it, "players_data");
+        if (cJSON_IsArray(pdata)) {
+            cJSON *refs = cJSON_AddArrayToObject(f, "players");
+            cJSON *p = NULL;
+            cJSON_ArrayForEach(p, pdata) {
+                if (!cJSON_IsObject(p)) continue;
+                const char *name = json_get_string(p, "name");
+                const char *web = json_get_string(p, "weblink");
+                const char *img = json_get_string(p, "image");
+                if (!name) name = "unknown";
+                if (!web) web = "";
+                if (!img) img = "";
+
+                char pid[17];
+                make_dim_id(pid, name, web, img);
+                if (!strset_has(&seenPlayers, pid)) {
+                    cJSON *po = cJSON_CreateObject();
+                    cJSON_AddStringToObject(po, "id", pid);
+                    cJSON_AddStringToObject(po, "name", name);
+                    cJSON_AddStringToObject(po, "weblink", web);
+                    cJSON_AddStringToObject(po, "image", img);
+                    cJSON_AddItemToArray(players, po);
+                    strset_add(&seenPlayers, pid);
+                }
+                cJSON_AddItemToArray(refs, cJSON_CreateString(pid));
+            }
+        } else {
+            /* not enriched yet: keep the compact names so enrichment can upgrade it later */
+            const char *names = json_get_string(it, "players");
+            cJSON_AddStringToObject(f, "players_text", names ? names : "");
+        }
+
+        cJSON_AddStringToObject(f, "weblink", link ? link : "");
+        const char *raw = json_get_string(it, "raw");
+        if (raw) cJSON_AddStringToObject(f, "raw", raw);
+        cJSON_AddItemToArray(facts, f);
+    }
+
+    strset_free(&seenGames);
+    strset_free(&seenCats);
+    strset_free(&seenPlayers);
+    return doc;
+}
+
+static void index_dim_table(StrMap *m, cJSON *table) {
+    cJSON *d = NULL;
+    cJSON_ArrayForEach(d, table) {
+        const char *id = json_get_string(d, "id");
+        if (id) strmap_put(m, id, d);
+    }
+}
+
+/*
+   Earliest verified_epoch whose facts could not be read back (failed checksum, or a
+   fact whose dimension rows were lost). main() rescans the feed from there, so a
+   damaged store costs a partial rescan instead of a silent gap or a cold start.
+*/
+static long g_store_lost_from = 0;
+
+static void store_note_lost(long epoch) {
+    if (g_store_lost_from == 0 || epoch < g_store_lost_from) g_store_lost_from = epoch;
+}
+
+/* A fact whose dimension rows are gone: rebuild it from its raw slice, else rescan its time. */
+static void store_rebuild_or_lose(cJSON *rows, cJSON *f, int *rebuilt) {
+    cJSON *row = raw_rebuild_row(f);
+    if (row) {
+        cJSON_AddItemToArray(rows, row);
+        (*rebuilt)++;
+    } else {
+        store_note_lost(json_get_long(f, "verified_epoch", 0));
+    }
+}
+
+static cJSON *store_join(cJSON *doc) {
+    cJSON *rows = cJSON_CreateArray();
+    if (!rows) return NULL;
+    int rebuilt = 0;
+
+    cJSON *facts = cJSON_GetObjectItemCaseSensitive(doc, "wrs");
+    if (!cJSON_IsArray(facts)) return rows;
+
+    StrMap games = {0}, cats = {0}, players = {0};
+    strmap_init(&games, 256);
+    strmap_init(&cats, 512);
+    strmap_init(&players, 1024);
+    index_dim_table(&games, cJSON_GetObjectItemCaseSensitive(doc, "games"));
+    index_dim_table(&cats, cJSON_GetObjectItemCaseSensitive(doc, "categories"));
+    index_dim_table(&players, cJSON_GetObjectItemCaseSensitive(doc, "players"));
+
+    cJSON *f = NULL;
+    cJSON_ArrayForEach(f, facts) {
+        const char *runId = json_get_string(f, "run_id");
+        if (!runId) continue;
+
+        const char *gref = json_get_string(f, "game");
+        const char *cref = json_get_string(f, "category");
+        cJSON *g = gref ? strmap_get(&games, gref) : NULL;
+        cJSON *c = cref ? strmap_get(&cats, cref) : NULL;
+        if ((gref && !g) || (cref && !c)) {
+            store_rebuild_or_lose(rows, f, &rebuilt);
+            continue;
+        }
+
+        const char *game = g ? json_get_string(g, "name") : NULL;
+        const char *cover = g ? json_get_string(g, "cover") : NULL;
+        const char *cat = c ? json_get_string(c, "category") : NULL;
+        const char *lvl = c ? json_get_string(c, "level") : NULL;
+        const char *iso = json_get_string(f, "verified_iso");
+        const char *sub = json_get_string(f, "subcats");
+        const char *link = json_get_string(f, "weblink");
+
+        cJSON *players_data = NULL;
+        char names[512];
+        names[0] = '\0';
+
+        cJSON *refs = cJSON_GetObjectItemCaseSensitive(f, "players");
+        int lost = 0;
+        cJSON *r = NULL;
+        cJSON_ArrayForEach(r, refs) {
+            if (cJSON_IsString(r) && !strmap_get(&players, r->valuestring)) lost = 1;
+        }
+        if (lost) {
+            store_rebuild_or_lose(rows, f, &rebuilt);
+            continue;
+        }
+        if (cJSON_IsArray(refs)) {
+            players_data = cJSON_CreateArray();
+            size_t used = 0;
+            int first = 1, full = 0;
+            cJSON_ArrayForEach(r, refs) {
+                cJSON *p = cJSON_IsString(r) ? strmap_get(&players, r->valuestring) : NULL;
+                if (!p) continue;
+                const char *name = json_get_string(p, "name");
+                const char *web = json_get_string(p, "weblink");
+                const char *img = json_get_string(p, "image");
+                if (!name) name = "unknown";
+
+                cJSON *o = cJSON_CreateObject();
+                cJSON_AddStringToObject(o, "name", name);
+                cJSON_AddStringToObject(o, "weblink", web ? web : "");
+                cJSON_AddStringToObject(o, "image", img ? img : "");
+                cJSON_AddItemToArray(players_data, o);
+
+                /* same shape as print_players_compact(): names stop at the first that doesn't fit */
+                if (full) continue;
+                char chunk[256];
+                snprintf(chunk, sizeof(chunk), "%s%s", first ? "" : ", ", name);
+                first = 0;
+                size_t clen = strlen(chunk);
+                if (used + clen + 1 >= sizeof(names)) { full = 1; continue; }
+                memcpy(names + used, chunk, clen);
+                used += clen;
+                names[used] = '\0';
+            }
+        } else {
+            const char *txt = json_get_string(f, "players_text");
+            snprintf(names, sizeof(names), "%s", txt ? txt : "");
+        }
+
+        cJSON *obj = cJSON_CreateObject();
+        cJSON_AddStringToObject(obj, "run_id", runId);
+        cJSON_AddNumberToObject(obj, "verified_epoch", (double)json_get_long(f, "verified_epoch", 0));
+        cJSON_AddStringToObject(obj, "verified_iso", iso ? iso : "");
+        cJSON_AddStringToObject(obj, "game", game ? game : "");
+        cJSON_AddStringToObject(obj, "game_cover", cover ? cover : "");
+        cJSON_AddStringToObject(obj, "category", cat ? cat : "");
+        cJSON_AddStringToObject(obj, "level", lvl ? lvl : "");
+        cJSON_AddStringToObject(obj, "subcats", sub ? sub : "");
+        cJSON_AddNumberToObject(obj, "primary_t", json_get_number(f, "primary_t", -1));
+        cJSON_AddStringToObject(obj, "players", names);
+        if (players_data) cJSON_AddItemToObject(obj, "players_data", players_data);
+        cJSON_AddStringToObject(obj, "weblink", link ? link : "");
+        const char *raw = json_get_string(f, "raw");
+        if (raw) cJSON_AddStringToObject(obj, "raw", raw);
+        cJSON_AddItemToArray(rows, obj);
+    }
+
+    strmap_free(&games);
+    strmap_free(&cats);
+    strmap_free(&players);
+    if (rebuilt) LOG("Store: rebuilt %d WR(s) with lost dimension rows from their raw slices", rebuilt);
+    return rows;
+}
+
+/* ----------------- committed store layout (data/store, one record per line) ----------------- */
+
+/*
+   The same tables as the schema-2 document, split for git:
+     data/store/games.jsonl, categories.jsonl, players.jsonl   dimension rows, sorted by id
+     data/store/wrs-YYYY-MM-DD.jsonl                           facts for one UTC day, sorted by
+                                                               (verified_epoch, run_id)
+   Every record is a single compact line and files are only rewritten when their
+   content changes. Days that fall out of retention are deleted.
+
+   Each file opens with a "#wrstore <version>" line. Records are grouped in blocks,
+   each closed by a trailer line
+     #crc32c <8 hex digits> <line count>
+   over the block's bytes. A block ends after a record whose key (run_id, or id for
+   dimension rows) hashes to 0 mod STORE_BLOCK_LINES, so boundaries move with the
+   keys and not with line positions: a run that adds two WRs touches those two lines
+   and the trailers of the blocks they land in, wherever in the file they sort
+   (plus any new dimension rows, likewise). A block is also cut at
+   STORE_BLOCK_MAX_LINES so an unlucky run of keys cannot make one huge block.
+
+   The last line is an end record
+     #end <blocks> <records>
+   so a file cut right after a trailer is told apart from a complete one.
+
+   A torn write or a flipped bit only loses the blocks it touches. An empty file, a
+   missing header or end record, records after the last trailer, an unterminated last
+   line or a record that does not parse also counts as damage, so the loader rechecks
+   what the file held instead of trusting a partial read.
+*/
+
+typedef enum { STORE_LAYOUT_DAYS, STORE_LAYOUT_JSON } StoreLayout;
+
+static StoreLayout g_store_layout = STORE_LAYOUT_DAYS;
+
+#define STORE_DIR "data/store"
+#define STORE_FILE_VERSION 1
+#define STORE_BLOCK_LINES 64         /* mean block length */
+#define STORE_BLOCK_MAX_LINES 256
+
+static int cmp_dim_id(const void *a, const void *b) {
+    const char *ia = json_get_string(*(cJSON* const*)a, "id");
+    const char *ib = json_get_string(*(cJSON* const*)b, "id");
+    return strcmp(ia ? ia : "", ib ? ib : "");
+}
+
+static int cmp_fact_oldest_first(const void *a, const void *b) {
+    cJSON *fa = *(cJSON* const*)a;
+    cJSON *fb = *(cJSON* const*)b;
+    long ta = json_get_long(fa, "verified_epoch", 0);
+    long tb = json_get_long(fb, "verified_epoch", 0);
+    if (ta < tb) return -1;
+    if (ta > tb) return 1;
+    const char *ra = json_get_string(fa, "run_id");
+    const char *rb = json_get_string(fb, "run_id");
+    return strcmp(ra ? ra : "", rb ? rb : "");
+}
+
+static cJSON **sorted_items(cJSON *arr, int *n_out, int (*cmp)(const void*, const void*)) {
+    *n_out = 0;
+    int n = cJSON_GetArraySize(arr);
+    if (n <= 0) return NULL;
+
+    cJSON **items = calloc((size_t)n, sizeof(cJSON*));
+    if (!items) return NULL;
+
+    int i = 0;
+    cJSON *it = NULL;
+    cJSON_ArrayForEach(it, arr) items[i++] = it;
+    qsort(items, (size_t)n, sizeof(cJSON*), cmp);
+    *n_out = n;
+    return items;
+}
+
+static int append_json_line(Buffer *b, cJSON *item) {
+    char *line = cJSON_PrintUnformatted(item);
+    if (!line) return 0;
+    int ok = buf_append(b, line, strlen(line)) && buf_append(b, "\n", 1);
+    free(line);
+    return ok;
+}
+
+/* does a block end after this record? keyed on content so inserts don't shift later cuts */
+static int block_ends_after(cJSON *item, const char *key_field) {
+    const char *key = json_get_string(item, key_field);
+    if (!key) return 0;
+    return g_isa->crc32c(0, key, strlen(key)) % STORE_BLOCK_LINES == 0;
+}
+
+static int write_lines_file(const char *path, cJSON **items, int n, const char *key_field) {
+    Buffer b = {0};
+    char header[32];
+    int hn = snprintf(header, sizeof(header), "#wrstore %d\n", STORE_FILE_VERSION);
+    if (!buf_append(&b, header, (size_t)hn)) { free(b.data); return 0; }
+    size_t block = b.size;
+    int lines = 0, blocks = 0;
+    for (int i = 0; i < n; i++) {
+        if (!append_json_line(&b, items[i])) { free(b.data); return 0; }
+        lines++;
+        if (block_ends_after(items[i], key_field) || lines == STORE_BLOCK_MAX_LINES || i == n - 1) {
+            char trailer[40];
+            int tn = snprintf(trailer, sizeof(trailer), "#crc32c %08x %d\n",
+                              g_isa->crc32c(0, b.data + block, b.size - block), lines);
+            if (!buf_append(&b, trailer, (size_t)tn)) { free(b.data); return 0; }
+            block = b.size;
+            lines = 0;
+            blocks++;
+        }
+    }
+    char footer[48];
+    int fn = snprintf(footer, sizeof(footer), "#end %d %d\n", blocks, n);
+    if (!buf_append(&b, footer, (size_t)fn)) { free(b.data); return 0; }
+    int ok = write_file_if_changed(path, b.data);
+    free(b.data);
+    return ok;
+}
+
+static void save_dim_table(cJSON *doc, const char *table) {
+    int n = 0;
+    cJSON **items = sorted_items(cJSON_GetObjectItemCaseSensitive(doc, table), &n, cmp_dim_id);
+
+    char path[256];
+    snprintf(path, sizeof(path), STORE_DIR "/%s.jsonl", table);
+    if (!write_lines_file(path, items, n, "id")) LOG("Failed to write %s", path);
+    free(items);
+}
+
+static void day_file_name(long epoch, char *out, size_t outsz) {
+    time_t t = (time_t)epoch;
+    struct tm tmv;
+    gmtime_r(&t, &tmv);
+    strftime(out, outsz, "wrs-%Y-%m-%d.jsonl", &tmv);
+}
+
+static int is_day_file_name(const char *name) {
+    size_t n = strlen(name);
+    return strncmp(name, "wrs-", 4) == 0 && n > 10 && strcmp(name + n - 6, ".jsonl") == 0;
+}
+
+static int store_days_save(cJSON *doc) {
+    if (!ensure_dir(STORE_DIR)) {
+        LOG("Failed to ensure %s", STORE_DIR);
+        return 0;
+    }
+
+    save_dim_table(doc, "games");
+    save_dim_table(doc, "categories");
+    save_dim_table(doc, "players");
+
+    int n = 0;
+    cJSON **facts = sorted_items(cJSON_GetObjectItemCaseSensitive(doc, "wrs"), &n, cmp_fact_oldest_first);
+
+    StrSet liveDays = {0};
+    strset_init(&liveDays, 16);
+
+    int files = 0, ok = 1;
+    for (int i = 0; i < n; ) {
+        char name[64];
+        day_file_name(json_get_long(facts[i], "verified_epoch", 0), name, sizeof(name));
+
+        int j = i + 1;
+        while (j < n) {
+            char nx[64];
+            day_file_name(json_get_long(facts[j], "verified_epoch", 0), nx, sizeof(nx));
+            if (strcmp(nx, name) != 0) break;
+            j++;
+        }
+
+        char path[256];
+        snprintf(path, sizeof(path), STORE_DIR "/%s", name);
+        if (!write_lines_file(path, facts + i, j - i, "run_id")) {
+            LOG("Failed to write %s", path);
+            ok = 0;
+        }
+        strset_add(&liveDays, name);
+        files++;
+        i = j;
+    }
+    free(facts);
+
+    DIR *d = opendir(STORE_DIR);
+    if (d) {
+        struct dirent *de;
+        while ((de = readdir(d)) != NULL) {
+            if (!is_day_file_name(de->d_name) || strset_has(&liveDays, de->d_name)) continue;
+            char path[512];
+            snprintf(path, sizeof(path), STORE_DIR "/%s", de->d_name);
+            if (unlink(path) == 0) LOG("Store: removed expired %s", path);
+            precompress_remove(path);
+        }
+        closedir(d);
+    }
+    strset_free(&liveDays);
+
+    LOG("Store: wrote %d day file(s) under %s", files, STORE_DIR);
+    return ok;
+}
+
+static int parse_lines_into(char *line, char *end, cJSON *dst, int *bad) {
+    int n = 0;
+    while (line < end) {
+        char *nl = memchr(line, '\n', (size_t)(end - line));
+        if (nl) *nl = '\0';
+        if (line[0]) {
+            cJSON *it = cJSON_Parse(line);
+            if (cJSON_IsObject(it)) { cJSON_AddItemToArray(dst, it); n++; }
+            else { cJSON_Delete(it); (*bad)++; }
+        }
+        line = nl ? nl + 1 : end;
+    }
+    return n;
+}
+
+/*
+   Large files are parsed on all cores: the buffer is cut at newline boundaries into
+   one chunk per thread, each thread builds its own array (glibc gives every thread
+   its own malloc arena, so the parsers do not contend on the heap), and the arrays
+   are spliced into dst in file order.
+*/
+#define STORE_PARSE_CHUNK_MIN (1 << 20)
+#define STORE_PARSE_MAX_THREADS 64
+
+typedef struct {
+    char *begin, *end;
+    cJSON *out;
+    int n, bad;
+} ParseChunk;
+
+static void *parse_chunk_thread(void *arg) {
+    ParseChunk *c = (ParseChunk *)arg;
+    c->out = cJSON_CreateArray();
+    c->n = c->out ? parse_lines_into(c->begin, c->end, c->out, &c->bad) : 0;
+    return NULL;
+}
+
+/* *bad counts the non-blank lines that did not parse as an object */
+static int parse_lines_parallel(char *begin, char *end, cJSON *dst, int *bad) {
+    size_t len = (size_t)(end - begin);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t nt = len / STORE_PARSE_CHUNK_MIN;
+    if (cpus > 0 && nt > (size_t)cpus) nt = (size_t)cpus;
+    if (nt > STORE_PARSE_MAX_THREADS) nt = STORE_PARSE_MAX_THREADS;
+    if (nt < 2) return parse_lines_into(begin, end, dst, bad);
+
+    ParseChunk chunks[STORE_PARSE_MAX_THREADS];
+    pthread_t tids[STORE_PARSE_MAX_THREADS];
+    int started[STORE_PARSE_MAX_THREADS] = {0};
+    char *at = begin;
+    for (size_t i = 0; i < nt; i++) {
+        char *cut = i == nt - 1 ? end : begin + len / nt * (i + 1);
+        if (cut < at) cut = at;
+        if (cut < end) {
+            char *nl = memchr(cut, '\n', (size_t)(end - cut));
+            cut = nl ? nl + 1 : end;
+        }
+        chunks[i] = (ParseChunk){ at, cut, NULL, 0, 0 };
+        at = cut;
+    }
+    /* chunk 0 runs here; a chunk whose thread cannot start runs here too */
+    for (size_t i = 1; i < nt; i++)
+        started[i] = pthread_create(&tids[i], NULL, parse_chunk_thread, &chunks[i]) == 0;
+    parse_chunk_thread(&chunks[0]);
+
+    int n = 0;
+    for (size_t i = 0; i < nt; i++) {
+        if (i > 0) {
+            if (started[i]) pthread_join(tids[i], NULL);
+            else parse_chunk_thread(&chunks[i]);
+        }
+        cJSON *it;
+        while (chunks[i].out && (it = chunks[i].out->child) != NULL)
+            cJSON_AddItemToArray(dst, cJSON_DetachItemViaPointer(chunks[i].out, it));
+        cJSON_Delete(chunks[i].out);
+        n += chunks[i].n;
+        *bad += chunks[i].bad;
+    }
+    return n;
+}
+
+/*
+   Parse one JSON record per line into dst. Blocks whose trailer does not match and
+   records after the last trailer are dropped. *damaged is set for those, for an
+   empty file, a missing or unknown header, a missing or mismatched end record, a
+   last line without its newline and lines that do not parse; what can still be
+   read is loaded either way.
+   Verification blanks the header, trailers and dropped blocks in place, then the
+   whole buffer is parsed at once.
+*/
+static int read_lines_into(const char *path, cJSON *dst, int *damaged) {
+    char *txt = read_file(path);
+    if (!txt) return 0;
+
+    char *end = txt + strlen(txt);
+    char *block = txt, *line = txt;
+    int n = 0, lines = 0, verified = 0, dropped = 0, bad = 0, hurt = 0;
+    int version = 0, used = 0, headed = 0, blocks = 0, records = 0, ended = 0;
+    int end_blocks = 0, end_records = 0;
+    if (sscanf(txt, "#wrstore %d%n", &version, &used) == 1 && used > 0 &&
+        (txt[used] == '\n' || txt[used] == '\0')) {
+        if (version > STORE_FILE_VERSION) {
+            LOG("Store: %s: unknown version %d; skipped", path, version);
+            if (damaged) *damaged = 1;
+            free(txt);
+            return 0;
+        }
+        char *nl = memchr(txt, '\n', (size_t)(end - txt));
+        line = block = nl ? nl + 1 : end;
+        memset(txt, '\n', (size_t)(line - txt));
+        headed = 1;
+    } else if (end > txt) {
+        LOG("Store: %s: no header; loading unverified", path);
+        hurt = 1;
+    } else {
+        LOG("Store: %s: empty", path);
+        hurt = 1;
+    }
+    if (end > txt && end[-1] != '\n') {
+        LOG("Store: %s: last line has no newline", path);
+        hurt = 1;
+    }
+    while (line < end) {
+        char *nl = memchr(line, '\n', (size_t)(end - line));
+        char *next = nl ? nl + 1 : end;
+        unsigned crc;
+        int count;
+        used = 0;
+        if (line[0] == '#' && sscanf(line, "#crc32c %8x %d%n", &crc, &count, &used) == 2 && used > 0) {
+            if (count != lines || g_isa->crc32c(0, block, (size_t)(line - block)) != crc) {
+                LOG("Store: %s: bad block at byte %ld (%d line(s)); dropped", path, (long)(block - txt), lines);
+                dropped += lines;
+                memset(block, '\n', (size_t)(line - block));
+            }
+            memset(line, '\n', (size_t)(next - line));
+            verified = 1;
+            blocks++;
+            records += count;
+            block = next;
+            lines = 0;
+        } else if (headed && !ended && line[0] == '#' &&
+                   sscanf(line, "#end %d %d%n", &end_blocks, &end_records, &used) == 2 && used > 0) {
+            if (lines > 0) {
+                LOG("Store: %s: %d line(s) without a trailer; dropped", path, lines);
+                dropped += lines;
+                memset(block, '\n', (size_t)(line - block));
+            }
+            memset(line, '\n', (size_t)(next - line));
+            ended = 1;
+            block = next;
+            lines = 0;
+        } else {
+            lines++;
+        }
+        line = next;
+    }
+    if (lines > 0 && (verified || headed)) {
+        LOG("Store: %s: unterminated tail (%d line(s)); dropped", path, lines);
+        dropped += lines;
+        end = block;
+    }
+    if (headed && !ended) {
+        LOG("Store: %s: no end record; file was cut short", path);
+        hurt = 1;
+    } else if (headed && (end_blocks != blocks || end_records != records)) {
+        LOG("Store: %s: end record says %d block(s)/%d record(s), found %d/%d",
+            path, end_blocks, end_records, blocks, records);
+        hurt = 1;
+    }
+    n = parse_lines_parallel(txt, end, dst, &bad);
+    if (bad) LOG("Store: %s: %d line(s) did not parse", path, bad);
+
+    if ((dropped || bad || hurt) && damaged) *damaged = 1;
+    free(txt);
+    return n;
+}
+
+static cJSON *store_days_load(void) {
+    cJSON *doc = cJSON_CreateObject();
+    if (!doc) return NULL;
+    cJSON_AddNumberToObject(doc, "schema", WR_STORE_SCHEMA);
+
+    const char *tables[] = { "games", "categories", "players" };
+    int dim_damaged = 0;
+    for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++) {
+        cJSON *arr = cJSON_AddArrayToObject(doc, tables[i]);
+        char path[256];
+        snprintf(path, sizeof(path), STORE_DIR "/%s.jsonl", tables[i]);
+        read_lines_into(path, arr, &dim_damaged);
+    }
+
+    cJSON *facts = cJSON_AddArrayToObject(doc, "wrs");
+    DIR *d = opendir(STORE_DIR);
+    if (d) {
+        struct dirent *de;
+        while ((de = readdir(d)) != NULL) {
+            if (!is_day_file_name(de->d_name)) continue;
+            char path[512];
+            snprintf(path, sizeof(path), STORE_DIR "/%s", de->d_name);
+            int damaged = 0;
+            read_lines_into(path, facts, &damaged);
+            if (damaged) {
+                /* the day in the name bounds what the dropped blocks held */
+                struct tm tmv;
+                memset(&tmv, 0, sizeof(tmv));
+                if (strptime(de->d_name, "wrs-%Y-%m-%d", &tmv)) store_note_lost((long)timegm(&tmv));
+            }
+        }
+        closedir(d);
+    }
+
+    /*
+       Lost dimension rows already show up as unjoinable facts, but a damaged table
+       says nothing about which days it served: recheck everything that is kept,
+       except facts with a raw slice, which carry their own dimensions.
+    */
+    if (dim_damaged) {
+        cJSON *f = NULL;
+        cJSON_ArrayForEach(f, facts) {
+            if (!json_get_string(f, "raw")) store_note_lost(json_get_long(f, "verified_epoch", 0));
+        }
+    }
+
+    cJSON *rows = store_join(doc);
+    cJSON_Delete(doc);
+    return rows;
+}
+
+/* Queue reads of exactly the files load_wrs_array() is going to parse. */
+static void store_prefetch(void) {
+    struct stat st;
+    if (g_store_layout != STORE_LAYOUT_DAYS || stat(STORE_DIR, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        io_prefetch("data/wrs.json");
+        return;
+    }
+    DIR *d = opendir(STORE_DIR);
+    if (!d) return;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        size_t n = strlen(de->d_name);
+        if (n < 7 || strcmp(de->d_name + n - 6, ".jsonl") != 0) continue;
+        char path[512];
+        snprintf(path, sizeof(path), STORE_DIR "/%s", de->d_name);
+        io_prefetch(path);
+    }
+    closedir(d);
+}
+
+static cJSON *load_wrs_array(void) {
+    struct stat st;
+    if (g_store_layout == STORE_LAYOUT_DAYS && stat(STORE_DIR, &st) == 0 && S_ISDIR(st.st_mode)) {
+        cJSON *rows = store_days_load();
+        return rows ? rows : cJSON_CreateArray();
+    }
+
+    /* JSON layout, or first run of the days layout migrating from data/wrs.json */
+    char *txt = read_file("data/wrs.json");
+    if (!txt) return cJSON_CreateArray();
+
+    cJSON *root = cJSON_Parse(txt);
+    free(txt);
+    if (!root) return cJSON_CreateArray();
+
+    /* legacy flat layout: already rows */
+    if (cJSON_IsArray(root)) return root;
+
+    if (!cJSON_IsObject(root) || json_get_long(root, "schema", 0) != WR_STORE_SCHEMA) {
+        cJSON_Delete(root);
+        return cJSON_CreateArray();
+    }
+
+    cJSON *rows = store_join(root);
+    cJSON_Delete(root);
+    return rows ? rows : cJSON_CreateArray();
+}
+
+static void save_wrs_array(cJSON *arr) {
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    WR_PROBE(store_save_start, g_store_layout == STORE_LAYOUT_DAYS ? "days" : "json", cJSON_GetArraySize(arr));
+
+    cJSON *doc = store_normalize(arr);
+    if (!doc) return;
+
+    LOG("Store: wrs=%d games=%d categories=%d players=%d",
+        cJSON_GetArraySize(cJSON_GetObjectItemCaseSensitive(doc, "wrs")),
+        cJSON_GetArraySize(cJSON_GetObjectItemCaseSensitive(doc, "games")),
+        cJSON_GetArraySize(cJSON_GetObjectItemCaseSensitive(doc, "categories")),
+        cJSON_GetArraySize(cJSON_GetObjectItemCaseSensitive(doc, "players")));
+
+    if (g_store_layout == STORE_LAYOUT_DAYS) {
+        int ok = store_days_save(doc);
+        cJSON_Delete(doc);
+        /* data/store now holds everything; drop the migrated single-file store */
+        if (ok && io_remove_after_writes("data/wrs.json")) {
+            LOG("Store: migrated data/wrs.json to %s", STORE_DIR);
+            precompress_remove("data/wrs.json");
+        }
+        WR_PROBE(store_save_done, ok, elapsed_us_since(&t0));
+        return;
+    }
+
+    char *out = cJSON_Print(doc);
+    cJSON_Delete(doc);
+    if (!out) return;
+    int ok = write_file_if_changed("data/wrs.json", out);
+    free(out);
+    if (!ok) LOG("Store: failed to write data/wrs.json");
+    WR_PROBE(store_save_done, ok, elapsed_us_since(&t0));
+}
+
+static void prune_old_wrs(cJSON *arr, time_t cutoff_epoch) {
+    if (!cJSON_IsArray(arr)) return;
+
+    for (int i = cJSON_GetArraySize(arr) - 1; i >= 0; i--) {
+        cJSON *it = cJSON_GetArrayItem(arr, i);
+        if (!cJSON_IsObject(it)) { cJSON_DeleteItemFromArray(arr, i); continue; }
+        long v = json_get_long(it, "verified_epoch", 0);
+        if (v < (long)cutoff_epoch) {
+            changes_record("prune", json_get_string(it, "run_id"), NULL);
+            cJSON_DeleteItemFromArray(arr, i);
+        }
+    }
+}
+
+static int wr_cmp_newest_first(const void *a, const void *b) {
+    const cJSON *oa = *(const cJSON* const*)a;
+    const cJSON *ob = *(const cJSON* const*)b;
+    long ta = json_get_long((cJSON*)oa, "verified_epoch", 0);
+    long tb = json_get_long((cJSON*)ob, "verified_epoch", 0);
+    if (ta > tb) return -1;
+    if (ta < tb) return 1;
+    /* ties: run_id, so the order does not depend on how the store was read back */
+    const char *ra = json_get_string((cJSON*)oa, "run_id");
+    const char *rb = json_get_string((cJSON*)ob, "run_id");
+    return strcmp(ra ? ra : "", rb ? rb : "");
+}
+
+static cJSON *sorted_wrs_dup(cJSON *arr) {
+    if (!cJSON_IsArray(arr)) return cJSON_CreateArray();
+    int n = cJSON_GetArraySize(arr);
+    if (n <= 1) return cJSON_Duplicate(arr, 1);
+
+    cJSON **items = calloc((size_t)n, sizeof(cJSON*));
+    if (!items) return cJSON_Duplicate(arr, 1);
+
+    for (int i = 0; i < n; i++) items[i] = cJSON_GetArrayItem(arr, i);
+    qsort(items, (size_t)n, sizeof(cJSON*), wr_cmp_newest_first);
+
+    cJSON *out = cJSON_CreateArray();
+    for (int i = 0; i < n; i++) cJSON_AddItemToArray(out, cJSON_Duplicate(items[i], 1));
+
+    free(items);
+    return out;
+}
+
+/* ----------------- published WR snapshots (epoch-based reclamation) ----------------- */
+
+/*
+   The scanner keeps mutating its own `wrs` array; everyone else reads an immutable
+   WrView published through g_view. A view is a sorted deep copy plus a parallel
+   verified_epoch array, so "rows since cutoff" is a binary search for a prefix.
+
+   Readers call view_pin(): they announce the current global epoch in a slot, then
+   load g_view; view_unpin() clears the slot. No locks on either side.
+   The single writer (main thread) swaps in a new view, bumps the epoch and retires
+   the old one. A retired view is freed once no slot holds an epoch older than its
+   retirement, because every reader that could still see it pinned before the swap.
+*/
+#include <stdatomic.h>
+#include <limits.h>
+#include <sched.h>
+#include <pthread.h>
+
+#define VIEW_READER_SLOTS 8
+
+typedef struct WrView {
+    cJSON *rows;          /* newest first, owned */
+    long *epochs;         /* verified_epoch of rows[i] */
+    int n;
+    unsigned long retired_at;
+    struct WrView *next;  /* retire list (writer only) */
+} WrView;
+
+static _Atomic(WrView *) g_view = NULL;
+static atomic_ulong g_view_epoch = 1;
+static atomic_ulong g_view_readers[VIEW_READER_SLOTS]; /* 0 = slot free */
+static WrView *g_view_retired = NULL;
+
+static void view_free(WrView *v) {
+    if (!v) return;
+    cJSON_Delete(v->rows);
+    free(v->epochs);
+    free(v);
+}
+
+static int view_pin(const WrView **out) {
+    for (;;) {
+        for (int i = 0; i < VIEW_READER_SLOTS; i++) {
+            unsigned long free_slot = 0;
+            unsigned long e = atomic_load(&g_view_epoch);
+            if (atomic_compare_exchange_strong(&g_view_readers[i], &free_slot, e)) {
+                *out = atomic_load(&g_view);
+                return i;
+            }
+        }
+        sched_yield(); /* more concurrent readers than slots */
+    }
+}
+
+static void view_unpin(int slot) {
+    atomic_store(&g_view_readers[slot], 0);
+}
+
+static void view_reclaim(void) {
+    unsigned long oldest = ULONG_MAX;
+    for (int i = 0; i < VIEW_READER_SLOTS; i++) {
+        unsigned long e = atomic_load(&g_view_readers[i]);
+        if (e && e < oldest) oldest = e;
+    }
+    for (WrView **pp = &g_view_retired; *pp; ) {
+        WrView *v = *pp;
+        if (v->retired_at <= oldest) { *pp = v->next; view_free(v); }
+        else pp = &v->next;
+    }
+}
+
+/* Writer only: replace the published view (NULL tears down) and retire the old one. */
+static void view_swap(WrView *nv) {
+    WrView *old = atomic_exchange(&g_view, nv);
+    unsigned long e = atomic_fetch_add(&g_view_epoch, 1) + 1;
+    if (old) {
+        old->retired_at = e;
+        old->next = g_view_retired;
+        g_view_retired = old;
+    }
+    view_reclaim();
+}
+
+/* Writer only: snapshot `wrs` (sorted newest first) and publish it. */
+static const WrView *view_publish(cJSON *wrs) {
+    WrView *v = (WrView *)calloc(1, sizeof(WrView));
+    if (!v) return atomic_load(&g_view);
+    v->rows = sorted_wrs_dup(wrs);
+    v->n = cJSON_GetArraySize(v->rows);
+    v->epochs = (long *)calloc(v->n ? (size_t)v->n : 1, sizeof(long));
+    if (!v->epochs) { view_free(v); return atomic_load(&g_view); }
+    int i = 0;
+    cJSON *it = NULL;
+    cJSON_ArrayForEach(it, v->rows) v->epochs[i++] = json_get_long(it, "verified_epoch", 0);
+
+    view_swap(v);
+    return v;
+}
+
+/* number of leading rows with verified_epoch >= cutoff */
+static int view_count_since(const WrView *v, time_t cutoff) {
+    int lo = 0, hi = v ? v->n : 0;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if ((time_t)v->epochs[mid] >= cutoff) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+/* ----------------- add WR entry (store game cover + players_data) ----------------- */
+
+/* raw: the packed API slice of `run` (--store-raw), or NULL */
+static void add_wr_entry_from_run(CURL *curl, ShardMap *catCache,
+                                 cJSON *wrs, ShardMap *runIds,
+                                 cJSON *run,
+                                 long verified_epoch,
+                                 const char *verify_date,
+                                 const char *raw) {
+    const char *runId = json_get_string(run, "id");
+    if (!runId) return;
+    if (shmap_has(runIds, runId)) return;
+
+    const char *weblink = json_get_string(run, "weblink");
+
+    const char *gameId = NULL, *gameName = NULL;
+    const char *catId  = NULL, *catName  = NULL;
+    const char *levelId = NULL, *levelName = NULL;
+
+    extract_id_and_name(cJSON_GetObjectItemCaseSensitive(run, "game"), &gameId, &gameName);
+    extract_id_and_name(cJSON_GetObjectItemCaseSensitive(run, "category"), &catId, &catName);
+    extract_id_and_name(cJSON_GetObjectItemCaseSensitive(run, "level"), &levelId, &levelName);
+
+    if (!gameId || !catId) return;
+
+    char cover_uri[1024];
+    run_cover_uri(run, cover_uri, sizeof(cover_uri));
+
+    double primary_t = -1;
+    cJSON *times = cJSON_GetObjectItemCaseSensitive(run, "times");
+    if (cJSON_IsObject(times)) primary_t = json_get_number(times, "primary_t", -1);
+
+    cJSON *valuesObj = cJSON_GetObjectItemCaseSensitive(run, "values");
+
+    char players[512];
+    print_players_compact(run, players, sizeof(players));
+
+    cJSON *players_data = build_players_array(run);
+
+    char *subcats = format_subcategories(curl, catCache, catId, valuesObj);
+
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddStringToObject(obj, "run_id", runId);
+    cJSON_AddNumberToObject(obj, "verified_epoch", (double)verified_epoch);
+    cJSON_AddStringToObject(obj, "verified_iso", verify_date ? verify_date : "");
+    cJSON_AddStringToObject(obj, "game", gameName ? gameName : gameId);
+    cJSON_AddStringToObject(obj, "game_cover", cover_uri[0] ? cover_uri : "");
+    cJSON_AddStringToObject(obj, "category", catName ? catName : catId);
+    cJSON_AddStringToObject(obj, "level", (levelId ? (levelName ? levelName : levelId) : ""));
+    cJSON_AddStringToObject(obj, "subcats", subcats ? subcats : "");
+    cJSON_AddNumberToObject(obj, "primary_t", primary_t);
+    cJSON_AddStringToObject(obj, "players", players);
+    if (players_data) {
+        cJSON_AddItemToObject(obj, "players_data", players_data);
+    }
+    cJSON_AddStringToObject(obj, "weblink", weblink ? weblink : "");
+    if (raw) cJSON_AddStringToObject(obj, "raw", raw);
+
+    free(subcats);
+
+    cJSON_AddItemToArray(wrs, obj);
+    shmap_add(runIds, runId);
+    changes_record("insert", runId, obj);
+}
+
+/* ----------------- fetch run details by id ----------------- */
+
+/* raw, if not NULL, receives the packed response slice under --store-raw (caller frees). */
+static cJSON *fetch_run_details(CURL *curl, const char *run_id, int embed, char **raw) {
+    if (raw) *raw = NULL;
+    if (!run_id || !run_id[0]) return NULL;
+
+    char url[512];
+    if (embed) {
+        snprintf(url, sizeof(url),
+                 "https://www.speedrun.com/api/v1/runs/%s?embed=game,category,players,level",
+                 run_id);
+    } else {
+        snprintf(url, sizeof(url),
+                 "https://www.speedrun.com/api/v1/runs/%s",
+                 run_id);
+    }
+
+    char *json = fetch_url(curl, url);
+    if (!json) return NULL;
+
+    cJSON *root = cJSON_Parse(json);
+    if (root && raw && g_store_raw) {
+        const char *slice;
+        size_t len;
+        if (json_data_slice(json, &slice, &len)) *raw = raw_pack(slice, len);
+    }
+    free(json);
+    if (!root) return NULL;
+
+    /* keep the parsed run itself rather than a deep copy of it */
+    cJSON *data = cJSON_DetachItemFromObjectCaseSensitive(root, "data");
+    cJSON_Delete(root);
+    if (!cJSON_IsObject(data)) {
+        cJSON_Delete(data);
+        if (raw) { free(*raw); *raw = NULL; }
+        return NULL;
+    }
+    return data;
+}
+
+static int get_run_verify_epoch_and_iso(cJSON *runObj, long *epoch_out, const char **iso_out) {
+    if (epoch_out) *epoch_out = 0;
+    if (iso_out) *iso_out = NULL;
+
+    cJSON *status = cJSON_GetObjectItemCaseSensitive(runObj, "status");
+    const char *verify_date = NULL;
+    if (cJSON_IsObject(status)) verify_date = json_get_string(status, "verify-date");
+    if (!verify_date) return 0;
+
+    time_t vtime = parse_iso8601_utc(verify_date);
+    if (vtime == (time_t)-1) return 0;
+
+    if (epoch_out) *epoch_out = (long)vtime;
+    if (iso_out) *iso_out = verify_date;
+    return 1;
+}
+
+/* ----------------- record history reconstruction per leaderboard key ----------------- */
+
+typedef struct LbRunInfo {
+    char *run_id;
+    double primary_t;
+    long verified_epoch;
+} LbRunInfo;
+
+static void free_lbruninfos(LbRunInfo *a, int n) {
+    if (!a) return;
+    for (int i = 0; i < n; i++) free(a[i].run_id);
+    free(a);
+}
+
+static int lbrun_cmp_epoch_asc(const void *a, const void *b) {
+    const LbRunInfo *ra = (const LbRunInfo*)a;
+    const LbRunInfo *rb = (const LbRunInfo*)b;
+    if (ra->verified_epoch < rb->verified_epoch) return -1;
+    if (ra->verified_epoch > rb->verified_epoch) return 1;
+    return 0;
+}
+
+static void track_leaderboard_history(CURL *curl, ShardMap *catCache,
+                                      cJSON *wrs, ShardMap *runIds,
+                                      const char *gameId, const char *catId, const char *levelId, cJSON *valuesObj,
+                                      time_t cutoff_epoch) {
+    const int TOPN = 200;
+    char url[2048];
+    build_leaderboard_url_top(url, sizeof(url), gameId, catId, levelId, valuesObj, TOPN);
+
+    char *json = fetch_url(curl, url);
+    if (!json) return;
+
+    cJSON *root = cJSON_Parse(json);
+    free(json);
+    if (!root) return;
+
+    cJSON *data = cJSON_GetObjectItemCaseSensitive(root, "data");
+    cJSON *runs = data ? cJSON_GetObjectItemCaseSensitive(data, "runs") : NULL;
+    if (!cJSON_IsArray(runs)) { cJSON_Delete(root); return; }
+
+    int n_entries = cJSON_GetArraySize(runs);
+    if (n_entries <= 0) { cJSON_Delete(root); return; }
+
+    LbRunInfo *infos = calloc((size_t)n_entries, sizeof(LbRunInfo));
+    if (!infos) { cJSON_Delete(root); return; }
+
+    int n = 0;
+    for (int i = 0; i < n_entries; i++) {
+        cJSON *entry = cJSON_GetArrayItem(runs, i);
+        if (!cJSON_IsObject(entry)) continue;
+
+        cJSON *runObj = cJSON_GetObjectItemCaseSensitive(entry, "run");
+        if (!cJSON_IsObject(runObj)) continue;
+
+        const char *rid = json_get_string(runObj, "id");
+        if (!rid) continue;
+
+        double pt = -1;
+        cJSON *times = cJSON_GetObjectItemCaseSensitive(runObj, "times");
+        if (cJSON_IsObject(times)) pt = json_get_number(times, "primary_t", -1);
+        if (pt < 0) continue;
+
+        long ve = 0;
+        const char *iso = NULL;
+        if (get_run_verify_epoch_and_iso(runObj, &ve, &iso)) {
+        } else {
+            ve = 0;
+        }
+
+        infos[n].run_id = strdup(rid);
+        infos[n].primary_t = pt;
+        infos[n].verified_epoch = ve;
+        n++;
+    }
+
+    cJSON_Delete(root);
+
+    WR_PROBE(history_board, gameId, catId, levelId ? levelId : "", n_entries, n);
+    if (n == 0) { free(infos); return; }
+
+    for (int i = 0; i < n; i++) {
+        if (infos[i].verified_epoch != 0) continue;
+        cJSON *runBare = fetch_run_details(curl, infos[i].run_id, 0, NULL);
+        if (!runBare) continue;
+
+        long ve = 0;
+        const char *iso = NULL;
+        if (get_run_verify_epoch_and_iso(runBare, &ve, &iso)) {
+            infos[i].verified_epoch = ve;
+        }
+        WR_PROBE(history_verify_backfill, infos[i].run_id, ve);
+        cJSON_Delete(runBare);
+        pace_sleep(2000);
+    }
+
+    double baseline_best = INFINITY;
+    for (int i = 0; i < n; i++) {
+        if (infos[i].verified_epoch > 0 && (time_t)infos[i].verified_epoch < cutoff_epoch) {
+            if (infos[i].primary_t < baseline_best) baseline_best = infos[i].primary_t;
+        }
+    }
+
+    LbRunInfo *cand = calloc((size_t)n, sizeof(LbRunInfo));
+    if (!cand) { free_lbruninfos(infos, n); return; }
+    int cN = 0;
+    for (int i = 0; i < n; i++) {
+        if (infos[i].verified_epoch <= 0) continue;
+        if ((time_t)infos[i].verified_epoch < cutoff_epoch) continue;
+        cand[cN].run_id = strdup(infos[i].run_id);
+        cand[cN].primary_t = infos[i].primary_t;
+        cand[cN].verified_epoch = infos[i].verified_epoch;
+        cN++;
+    }
+
+    free_lbruninfos(infos, n);
+
+    /* baseline in milliseconds, -1 when nothing predates the window */
+    WR_PROBE(history_candidates, gameId, catId, cN, isfinite(baseline_best) ? (long)(baseline_best * 1000.0) : -1L);
+    if (cN == 0) { free_lbruninfos(cand, cN); return; }
+
+    qsort(cand, (size_t)cN, sizeof(LbRunInfo), lbrun_cmp_epoch_asc);
+
+    const double EPS = 1e-6;
+    double best = baseline_best;
+    int have_baseline = isfinite(best);
+    int added = 0;
+
+    for (int i = 0; i < cN; i++) {
+        int include = 0;
+        if (!have_baseline) {
+            include = 1;
+            best = cand[i].primary_t;
+            have_baseline = 1;
+        } else {
+            double tt = cand[i].primary_t;
+            if (tt < best - EPS) {
+                include = 1;
+                best = tt;
+            } else if (fabs(tt - best) <= EPS) {
+                include = 1;
+            }
+        }
+
+        if (!include) continue;
+        if (shmap_has(runIds, cand[i].run_id)) continue;
+
+        char *raw = NULL;
+        cJSON *runFull = fetch_run_details(curl, cand[i].run_id, 1, &raw);
+        if (!runFull) continue;
+
+        long ve = 0;
+        const char *iso = NULL;
+        if (!get_run_verify_epoch_and_iso(runFull, &ve, &iso)) {
+            cJSON_Delete(runFull);
+            free(raw);
+            continue;
+        }
+
+        if ((time_t)ve >= cutoff_epoch) {
+            add_wr_entry_from_run(curl, catCache, wrs, runIds, runFull, ve, iso, raw);
+            WR_PROBE(history_add, cand[i].run_id, ve);
+            added++;
+        }
+
+        cJSON_Delete(runFull);
+        free(raw);
+        pace_sleep(3000);
+    }
+
+    WR_PROBE(history_done, gameId, catId, added);
+    free_lbruninfos(cand, cN);
+}
+
+/* ----------------- bounded queues with spill-to-disk (scan pipeline) ----------------- */
+
+/*
+   FIFO of opaque byte records. Up to `budget` bytes live in memory; anything pushed
+   beyond that (or while older records are still on disk) is appended to an
+   unlinked temp file and paged back in, budget-sized, once memory drains. So a
+   backlog of any length costs at most ~budget bytes per queue.
+*/
+typedef struct SqItem {
+    struct SqItem *next;
+    size_t len;
+    char data[];
+} SqItem;
+
+typedef struct {
+    const char *name;
+    size_t budget;
+    SqItem *head, *tail;
+    size_t mem_bytes, peak_bytes;
+    FILE *spill;
+    long spill_unread;    /* records on disk not yet paged in */
+    long rd_off;          /* read offset in the spill file */
+    long pushed, spilled;
+} SpillQueue;
+
+static size_t g_queue_budget = 4u << 20; /* --queue-mem */
+
+static void sq_init(SpillQueue *q, const char *name) {
+    memset(q, 0, sizeof(*q));
+    q->name = name;
+    q->budget = g_queue_budget;
+}
+
+static int sq_mem_append(SpillQueue *q, const char *data, size_t len) {
+    SqItem *it = (SqItem *)malloc(sizeof(SqItem) + len + 1);
+    if (!it) return 0;
+    it->next = NULL;
+    it->len = len;
+    memcpy(it->data, data, len);
+    it->data[len] = '\0';
+    if (q->tail) q->tail->next = it; else q->head = it;
+    q->tail = it;
+    q->mem_bytes += len;
+    if (q->mem_bytes > q->peak_bytes) q->peak_bytes = q->mem_bytes;
+    return 1;
+}
+
+/* 0 if the record was lost (no memory, or the spill write failed). */
+static int sq_push(SpillQueue *q, const char *data, size_t len) {
+    q->pushed++;
+    if (q->spill_unread == 0 && q->mem_bytes + len <= q->budget) return sq_mem_append(q, data, len);
+    if (!q->spill) {
+        q->spill = tmpfile();
+        if (!q->spill) return sq_mem_append(q, data, len); /* no disk: stay correct, not flat */
+    }
+    uint32_t n = (uint32_t)len;
+    long end = fseek(q->spill, 0, SEEK_END) == 0 ? ftell(q->spill) : -1;
+    if (end < 0 || fwrite(&n, sizeof(n), 1, q->spill) != 1 || fwrite(data, 1, len, q->spill) != len ||
+        fflush(q->spill) != 0) {
+        LOG("Queue %s: spill write failed; record lost", q->name);
+        /* cut a partial record off so the records behind it still read back */
+        clearerr(q->spill);
+        if (end >= 0 && ftruncate(fileno(q->spill), end) != 0) q->spill_unread = 0;
+        return 0;
+    }
+    q->spill_unread++;
+    q->spilled++;
+    return 1;
+}
+
+/* Move up to one budget of spilled records back into memory. */
+static void sq_page_in(SpillQueue *q) {
+    if (fseek(q->spill, q->rd_off, SEEK_SET) != 0) { q->spill_unread = 0; return; }
+    char *tmp = NULL;
+    size_t cap = 0;
+    while (q->spill_unread > 0 && (q->mem_bytes == 0 || q->mem_bytes < q->budget)) {
+        uint32_t n;
+        if (fread(&n, sizeof(n), 1, q->spill) != 1) { q->spill_unread = 0; break; }
+        if (n + 1 > cap) {
+            char *p = realloc(tmp, n + 1);
+            if (!p) { q->spill_unread = 0; break; }
+            tmp = p;
+            cap = n + 1;
+        }
+        if (fread(tmp, 1, n, q->spill) != n) { q->spill_unread = 0; break; }
+        sq_mem_append(q, tmp, n);
+        q->spill_unread--;
+    }
+    free(tmp);
+    q->rd_off = ftell(q->spill);
+    if (q->spill_unread == 0) {
+        /* fully drained: reuse the file from the start */
+        if (ftruncate(fileno(q->spill), 0) == 0) rewind(q->spill);
+        q->rd_off = 0;
+    }
+}
+
+/* Oldest record (caller frees), or NULL when empty. */
+static char *sq_pop(SpillQueue *q, size_t *len) {
+    if (!q->head && q->spill_unread > 0) sq_page_in(q);
+    SqItem *it = q->head;
+    if (!it) return NULL;
+    q->head = it->next;
+    if (!q->head) q->tail = NULL;
+    q->mem_bytes -= it->len;
+    if (len) *len = it->len;
+    /* hand the record out in place of the node */
+    char *out = (char *)it;
+    memmove(out, it->data, it->len + 1);
+    return out;
+}
+
+static void sq_free(SpillQueue *q) {
+    if (q->pushed) {
+        LOG("Queue %s: pushed=%ld spilled=%ld peak_mem=%zu bytes (budget %zu)",
+            q->name, q->pushed, q->spilled, q->peak_bytes, q->budget);
+    }
+    for (SqItem *it = q->head, *next; it; it = next) { next = it->next; free(it); }
+    if (q->spill) fclose(q->spill);
+    memset(q, 0, sizeof(*q));
+}
+
+/* ----------------- memory governor (cgroup + PSI) ----------------- */
+
+/*
+   Watches memory pressure while a scan runs, so a long backlog in a memory-limited
+   cgroup sheds caches instead of getting OOM-killed. Signals, polled at most once
+   a second: PSI (the cgroup's memory.pressure, else /proc/pressure/memory), usage
+   against the limit (memory.current vs memory.max/memory.high) and new high, max
+   and oom events in memory.events. The scan acts on the level at its safe points
+   (scan_govern()):
+     some  top-1 cache cut to half, queue budgets to a quarter, short pause per batch
+     full  top-1 cache dropped, category cache cut to half, minimal queue budgets,
+           one check worker, longer pause
+   A level only drops once every signal is well below its threshold again.
+*/
+#define MEM_POLL_SEC 1.0
+#define MEM_PSI_ENTER 10.0      /* avg10 % */
+#define MEM_PSI_LEAVE 5.0
+#define MEM_RATIO_SOME 0.75     /* of the cgroup's limit */
+#define MEM_RATIO_FULL 0.90
+#define MEM_RATIO_LEAVE 0.65
+#define MEM_QUEUE_MIN (64u << 10)
+#define MEM_PAUSE_SOME_MS 100
+#define MEM_PAUSE_FULL_MS 500
+
+typedef enum { MEM_OK, MEM_SOME, MEM_FULL } MemLevel;
+
+static const char *const k_mem_names[] = { "ok", "some", "full" };
+static const char *const k_mem_events[] = { "high", "max", "oom", "oom_kill" };
+
+static const char *g_mem_cgroup = NULL;     /* --mem-cgroup: NULL = own cgroup, "off" */
+
+typedef struct {
+    int ready, on;
+    char dir[512];             /* cgroup directory, "" if none */
+    char psi[600];             /* pressure file, "" if none */
+    double last_poll;
+    int fresh;                 /* polled since the scan last shrank its caches */
+    long long events[4];
+    int have_events;
+    MemLevel level;
+    long transitions, evicted, pause_ms;
+} MemGov;
+
+static MemGov g_mem;
+
+static double mem_clock(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+/* First line of dir/name, or 0 if it can't be read. */
+static int mem_read_line(const char *dir, const char *name, char *buf, size_t cap) {
+    char path[700];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    int ok = fgets(buf, (int)cap, fp) != NULL;
+    fclose(fp);
+    return ok;
+}
+
+/* The cgroup v2 directory this process runs in, from /proc/self/cgroup ("0::/path"). */
+static int mem_own_cgroup(char *dir, size_t cap) {
+    FILE *fp = fopen("/proc/self/cgroup", "r");
+    if (!fp) return 0;
+    char line[480];
+    int ok = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "0::", 3) != 0) continue;
+        line[strcspn(line, "\n")] = '\0';
+        snprintf(dir, cap, "/sys/fs/cgroup%s", strcmp(line + 3, "/") == 0 ? "" : line + 3);
+        ok = 1;
+        break;
+    }
+    fclose(fp);
+    return ok;
+}
+
+/* "some avg10" and "full avg10" of a PSI file; 0 if unreadable. */
+static int mem_read_psi(const char *path, double *some, double *full) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    char line[256];
+    int got = 0;
+    *some = *full = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        double v;
+        if (sscanf(line, "some avg10=%lf", &v) == 1) { *some = v; got = 1; }
+        else if (sscanf(line, "full avg10=%lf", &v) == 1) { *full = v; got = 1; }
+    }
+    fclose(fp);
+    return got;
+}
+
+/* memory.current over the tighter of memory.max and memory.high; -1 without a limit. */
+static double mem_usage_ratio(const char *dir) {
+    char buf[64];
+    if (!mem_read_line(dir, "memory.current", buf, sizeof(buf))) return -1;
+    double cur = strtod(buf, NULL), limit = 0;
+    static const char *const limits[] = { "memory.max", "memory.high" };
+    for (int i = 0; i < 2; i++) {
+        if (!mem_read_line(dir, limits[i], buf, sizeof(buf)) || strncmp(buf, "max", 3) == 0) continue;
+        double v = strtod(buf, NULL);
+        if (v > 0 && (limit == 0 || v < limit)) limit = v;
+    }
+    return limit > 0 ? cur / limit : -1;
+}
+
+/* memory.events counters (k_mem_events order); 0 if unreadable. */
+static int mem_read_events(const char *dir, long long ev[4]) {
+    char path[700];
+    snprintf(path, sizeof(path), "%s/memory.events", dir);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    char line[128];
+    memset(ev, 0, 4 * sizeof(long long));
+    while (fgets(line, sizeof(line), fp)) {
+        char name[32];
+        long long v;
+        if (sscanf(line, "%31s %lld", name, &v) != 2) continue;
+        for (int i = 0; i < 4; i++) if (strcmp(name, k_mem_events[i]) == 0) ev[i] = v;
+    }
+    fclose(fp);
+    return 1;
+}
+
+static void mem_init(void) {
+    g_mem.ready = 1;
+    if (g_mem_cgroup && strcmp(g_mem_cgroup, "off") == 0) return;
+
+    if (g_mem_cgroup) snprintf(g_mem.dir, sizeof(g_mem.dir), "%s", g_mem_cgroup);
+    else if (!mem_own_cgroup(g_mem.dir, sizeof(g_mem.dir))) g_mem.dir[0] = '\0';
+
+    double some, full;
+    if (g_mem.dir[0]) {
+        snprintf(g_mem.psi, sizeof(g_mem.psi), "%s/memory.pressure", g_mem.dir);
+        if (!mem_read_psi(g_mem.psi, &some, &full)) g_mem.psi[0] = '\0';
+    }
+    if (!g_mem.psi[0] && mem_read_psi("/proc/pressure/memory", &some, &full))
+        snprintf(g_mem.psi, sizeof(g_mem.psi), "/proc/pressure/memory");
+
+    int have_ratio = g_mem.dir[0] && mem_usage_ratio(g_mem.dir) >= 0;
+    g_mem.have_events = g_mem.dir[0] && mem_read_events(g_mem.dir, g_mem.events);
+    g_mem.on = g_mem.psi[0] || have_ratio || g_mem.have_events;
+    if (!g_mem.on) {
+        LOG("Memory governor: no PSI or cgroup memory files; off");
+        return;
+    }
+    LOG("Memory governor: cgroup=%s psi=%s limit=%s events=%s",
+        g_mem.dir[0] ? g_mem.dir : "-", g_mem.psi[0] ? g_mem.psi : "-",
+        have_ratio ? "yes" : "no", g_mem.have_events ? "yes" : "no");
+}
+
+/* Current level, re-read from the signals at most once per MEM_POLL_SEC. */
+static MemLevel mem_level(void) {
+    if (!g_mem.ready) mem_init();
+    if (!g_mem.on) return MEM_OK;
+    double t = mem_clock();
+    if (g_mem.last_poll > 0 && t - g_mem.last_poll < MEM_POLL_SEC) return g_mem.level;
+    g_mem.last_poll = t;
+    g_mem.fresh = 1;
+
+    double some = 0, full = 0;
+    if (g_mem.psi[0]) mem_read_psi(g_mem.psi, &some, &full);
+    double ratio = g_mem.dir[0] ? mem_usage_ratio(g_mem.dir) : -1;
+
+    long long ev[4], d[4] = { 0, 0, 0, 0 };
+    if (g_mem.have_events && mem_read_events(g_mem.dir, ev)) {
+        for (int i = 0; i < 4; i++) { d[i] = ev[i] - g_mem.events[i]; g_mem.events[i] = ev[i]; }
+    }
+
+    MemLevel want = MEM_OK;
+    if (full >= MEM_PSI_ENTER || ratio >= MEM_RATIO_FULL || d[1] > 0 || d[2] > 0 || d[3] > 0) want = MEM_FULL;
+    else if (some >= MEM_PSI_ENTER || ratio >= MEM_RATIO_SOME || d[0] > 0) want = MEM_SOME;
+
+    /* rise at once; fall only when everything is clearly back down */
+    MemLevel next = g_mem.level;
+    if (want > g_mem.level) next = want;
+    else if (want < g_mem.level && some < MEM_PSI_LEAVE && full < MEM_PSI_LEAVE && ratio < MEM_RATIO_LEAVE)
+        next = want;
+
+    if (next != g_mem.level) {
+        g_mem.transitions++;
+        LOG("Memory governor: %s -> %s (psi some=%.2f full=%.2f usage=%.0f%% events high+%lld max+%lld oom+%lld)",
+            k_mem_names[g_mem.level], k_mem_names[next], some, full, ratio >= 0 ? ratio * 100 : 0,
+            d[0], d[1], d[2] + d[3]);
+        g_mem.level = next;
+    }
+    return g_mem.level;
+}
+
+static void mem_pause(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+    g_mem.pause_ms += ms;
+}
+
+/* ----------------- scan runs feed, detect new current-WR keys, then backfill history ----------------- */
+
+/*
+   Three stages joined by SpillQueues, so a long outage's backlog is held as compact
+   tab-separated records (bounded by --queue-mem, rest on disk) rather than page DOMs:
+     feed    -> work:   vtime \t runId \t gameId \t catId \t levelId \t values-json
+     check   -> result: same record + \t lb-key, for runs that are the current WR of a new key
+     history <- result: drained every SCAN_RESULT_BATCH keys and once at the end
+   The feed stage is either the paged /runs walk below or runs handed in through
+   wrd_ingest_page()/wrd_ingest_run(); both go through a ScanCtx.
+
+   With --jobs=N > 1 the check stage runs on N workers (one curl handle each) over
+   batches of SCAN_CHECK_BATCH records per worker, sharing the top-1 cache, the
+   processed-key set and runIds through sharded maps. A batch's results are queued
+   in record order once it is joined, and the main thread backfills the previous
+   batch's keys while the workers check the next one.
+*/
+#define SCAN_RESULT_BATCH 32
+#define SCAN_CHECK_BATCH 16
+#define SCAN_MAX_JOBS 64
+
+static int g_scan_jobs = 1;
+
+typedef struct {
+    CURL *curl;
+    ShardMap *catCache;
+    ShardMap *lbCache;
+    cJSON *wrs;
+    ShardMap *runIds;
+    long scan_floor;          /* stop paging below this verify time (0: never) */
+    long recheck_from;        /* > 0: re-test stored runs verified since (store damage) */
+    time_t prune_cutoff;
+    long new_last_seen;
+
+    SpillQueue work, results;
+    long start_seen;          /* last_seen when the scan began */
+    long lost;                /* queued records dropped by a failed push */
+    ShardMap processedKeys;
+    long runs_seen, runs_checked, keys_processed;   /* checked/processed: atomic under --jobs */
+    int published, pending;
+    CURL *workers[SCAN_MAX_JOBS];                    /* --jobs handles, made on first use */
+} ScanCtx;
+
+static void scan_begin(ScanCtx *sc, CURL *curl, ShardMap *catCache, ShardMap *lbCache,
+                       cJSON *wrs, ShardMap *runIds, long last_seen_epoch, time_t prune_cutoff_epoch) {
+    memset(sc, 0, sizeof(*sc));
+    sc->curl = curl;
+    sc->catCache = catCache;
+    sc->lbCache = lbCache;
+    sc->wrs = wrs;
+    sc->runIds = runIds;
+    sc->prune_cutoff = prune_cutoff_epoch;
+    sc->new_last_seen = last_seen_epoch;
+    sc->start_seen = last_seen_epoch;
+    sq_init(&sc->work, "work");
+    sq_init(&sc->results, "result");
+    shmap_init(&sc->processedKeys, 1024, NULL);
+    sc->published = cJSON_GetArraySize(wrs);
+}
+
+static void scan_push(ScanCtx *sc, SpillQueue *q, const char *rec, size_t len) {
+    if (!sq_push(q, rec, len)) sc->lost++;
+}
+
+/* Split `rec` in place on tabs into at most n fields; returns the count. */
+static int scan_fields(char *rec, char **f, int n) {
+    int k = 0;
+    f[k++] = rec;
+    for (char *p = rec; *p && k < n; p++) {
+        if (*p == '\t') { *p = '\0'; f[k++] = p + 1; }
+    }
+    return k;
+}
+
+/* Feed stage, one run: returns 1 if queued, 0 if outside the window. */
+static int scan_queue_run(ScanCtx *sc, long vtime, const char *runId, const char *gameId,
+                          const char *catId, const char *levelId, const char *values) {
+    sc->runs_seen++;
+    if (vtime > sc->new_last_seen) sc->new_last_seen = vtime;
+    if (vtime < (long)sc->prune_cutoff) return 0;
+
+    char *rec = NULL;
+    int len = asprintf(&rec, "%ld\t%s\t%s\t%s\t%s\t%s", vtime,
+                       runId ? runId : "", gameId ? gameId : "", catId ? catId : "",
+                       levelId ? levelId : "", values ? values : "null");
+    if (len < 0) return 0;
+    scan_push(sc, &sc->work, rec, (size_t)len);
+    free(rec);
+    return 1;
+}
+
+/* A feed run's verify time, or -1. */
+static time_t feed_vtime(cJSON *run) {
+    const char *verify_date = NULL;
+    cJSON *status = cJSON_IsObject(run) ? cJSON_GetObjectItemCaseSensitive(run, "status") : NULL;
+    if (cJSON_IsObject(status)) verify_date = json_get_string(status, "verify-date");
+    return parse_iso8601_utc(verify_date);
+}
+
+/*
+   Feed stage, one /runs page minus its first `skip` runs (already read from the
+   previous page): returns 1 once a run older than scan_floor is reached.
+*/
+static int scan_queue_page(ScanCtx *sc, cJSON *data, int skip) {
+    cJSON *run = NULL;
+    int i = 0;
+    cJSON_ArrayForEach(run, data) {
+        if (i++ < skip || !cJSON_IsObject(run)) continue;
+
+        time_t vtime = feed_vtime(run);
+        if (vtime == (time_t)-1) continue;
+
+        if ((long)vtime < sc->scan_floor) {
+            sc->runs_seen++;
+            return 1;
+        }
+
+        const char *gameId = NULL, *gameName = NULL;
+        const char *catId  = NULL, *catName  = NULL;
+        const char *levelId = NULL, *levelName = NULL;
+
+        extract_id_and_name(cJSON_GetObjectItemCaseSensitive(run, "game"), &gameId, &gameName);
+        extract_id_and_name(cJSON_GetObjectItemCaseSensitive(run, "category"), &catId, &catName);
+        extract_id_and_name(cJSON_GetObjectItemCaseSensitive(run, "level"), &levelId, &levelName);
+
+        cJSON *valuesObj = cJSON_GetObjectItemCaseSensitive(run, "values");
+        char *values = valuesObj ? cJSON_PrintUnformatted(valuesObj) : NULL;
+        scan_queue_run(sc, (long)vtime, json_get_string(run, "id"), gameId, catId, levelId, values);
+        free(values);
+    }
+    return 0;
+}
+
+/* History stage: backfill every queued key, then let readers see the additions. */
+static void scan_drain_results(ScanCtx *sc) {
+    char *rec;
+    while ((rec = sq_pop(&sc->results, NULL)) != NULL) {
+        char *f[7];
+        if (scan_fields(rec, f, 7) == 7) {
+            const char *levelId = f[4][0] ? f[4] : NULL;
+            cJSON *valuesObj = cJSON_Parse(f[5]);
+            LOG("New current WR detected; backfilling history for key: %s", f[6]);
+            WR_PROBE(wr_detected, f[1], f[6], strtol(f[0], NULL, 10));
+            track_leaderboard_history(sc->curl, sc->catCache, sc->wrs, sc->runIds,
+                                      f[2], f[3], levelId, valuesObj, sc->prune_cutoff);
+            cJSON_Delete(valuesObj);
+        }
+        free(rec);
+    }
+    sc->pending = 0;
+    if (cJSON_GetArraySize(sc->wrs) != sc->published) {
+        view_publish(sc->wrs);
+        sc->published = cJSON_GetArraySize(sc->wrs);
+    }
+}
+
+/* Check stage, one work record: the result record if it is the current WR of a new key. */
+static char *scan_check(ScanCtx *sc, CURL *curl, char *rec) {
+    long checked = __atomic_add_fetch(&sc->runs_checked, 1, __ATOMIC_RELAXED);
+
+    char *f[6];
+    if (scan_fields(rec, f, 6) != 6 || !f[1][0] || !f[2][0] || !f[3][0]) return NULL;
+    if (shmap_has(sc->runIds, f[1]) &&
+        !(sc->recheck_from > 0 && strtol(f[0], NULL, 10) >= sc->recheck_from)) return NULL;
+
+    const char *levelId = f[4][0] ? f[4] : NULL;
+    cJSON *valuesObj = cJSON_Parse(f[5]);
+    char *out = NULL;
+
+    if (is_current_wr(curl, sc->lbCache, f[1], f[2], f[3], levelId, valuesObj)) {
+        char *key = make_lb_key(f[2], f[3], levelId, valuesObj);
+        if (key && shmap_add(&sc->processedKeys, key)) {
+            __atomic_add_fetch(&sc->keys_processed, 1, __ATOMIC_RELAXED);
+            /* fields are NUL-split in rec; rebuild the record with the key */
+            if (asprintf(&out, "%s\t%s\t%s\t%s\t%s\t%s\t%s",
+                         f[0], f[1], f[2], f[3], f[4], f[5], key) < 0) out = NULL;
+        }
+        free(key);
+    }
+    cJSON_Delete(valuesObj);
+
+    if ((checked % 40) == 0) pace_sleep(2000);
+    return out;
+}
+
+/*
+   Safe point (no cached value in use, no worker running): apply the memory level.
+   Caches shrink once per poll, the pause is per batch. Returns the workers to use.
+*/
+static int scan_govern(ScanCtx *sc, int jobs) {
+    MemLevel lvl = mem_level();
+    if (lvl == MEM_OK) {
+        sc->work.budget = sc->results.budget = g_queue_budget;
+        return jobs;
+    }
+
+    size_t budget = lvl == MEM_FULL ? MEM_QUEUE_MIN : g_queue_budget / 4;
+    if (budget < MEM_QUEUE_MIN) budget = MEM_QUEUE_MIN;
+    if (budget > g_queue_budget) budget = g_queue_budget;
+    sc->work.budget = sc->results.budget = budget;
+
+    if (g_mem.fresh) {
+        g_mem.fresh = 0;
+        size_t n = shmap_shrink(sc->lbCache, lvl == MEM_FULL ? 0.0 : 0.5);
+        if (lvl == MEM_FULL) n += shmap_shrink(sc->catCache, 0.5);
+        if (n) LOG("Memory governor: evicted %zu cache entries", n);
+        g_mem.evicted += (long)n;
+    }
+    mem_pause(lvl == MEM_FULL ? MEM_PAUSE_FULL_MS : MEM_PAUSE_SOME_MS);
+    return lvl == MEM_FULL ? 1 : jobs;
+}
+
+static void scan_push_result(ScanCtx *sc, char *out) {
+    if (!out) return;
+    scan_push(sc, &sc->results, out, strlen(out));
+    sc->pending++;
+    free(out);
+}
+
+typedef struct {
+    ScanCtx *sc;
+    char **recs, **outs;
+    int n, next;              /* next record to claim (atomic) */
+} CheckBatch;
+
+typedef struct {
+    CheckBatch *batch;
+    CURL *curl;
+} CheckWorker;
+
+static void *scan_check_worker(void *arg) {
+    CheckWorker *w = (CheckWorker *)arg;
+    CheckBatch *b = w->batch;
+    int i;
+    while ((i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED)) < b->n)
+        b->outs[i] = scan_check(b->sc, w->curl, b->recs[i]);
+    return NULL;
+}
+
+/* --jobs > 1: batches checked on the workers while this thread runs the history stage. */
+static void scan_process_parallel(ScanCtx *sc, int jobs) {
+    int handles = 0;
+    while (handles < jobs && (sc->workers[handles] || (sc->workers[handles] = curl_easy_init())))
+        handles++;
+
+    int cap = SCAN_CHECK_BATCH * jobs;
+    char **recs = calloc((size_t)cap, sizeof(char *));
+    char **outs = calloc((size_t)cap, sizeof(char *));
+    if (!recs || !outs) { free(recs); free(outs); return; }
+
+    for (;;) {
+        int active = scan_govern(sc, handles);
+        int n = 0;
+        while (n < SCAN_CHECK_BATCH * active && (recs[n] = sq_pop(&sc->work, NULL)) != NULL) n++;
+        if (n == 0) break;
+        memset(outs, 0, (size_t)n * sizeof(char *));
+
+        CheckBatch b = { sc, recs, outs, n, 0 };
+        CheckWorker w[SCAN_MAX_JOBS];
+        pthread_t tids[SCAN_MAX_JOBS];
+        int started = 0;
+        for (int j = 0; j < active; j++) {
+            w[started] = (CheckWorker){ &b, sc->workers[j] };
+            if (pthread_create(&tids[started], NULL, scan_check_worker, &w[started]) == 0) started++;
+        }
+
+        if (sc->pending > 0) scan_drain_results(sc);
+        if (started == 0) {
+            /* no worker could start: check on this thread after all */
+            CheckWorker self = { &b, sc->curl };
+            scan_check_worker(&self);
+        }
+        for (int j = 0; j < started; j++) pthread_join(tids[j], NULL);
+
+        for (int i = 0; i < n; i++) {
+            scan_push_result(sc, outs[i]);
+            free(recs[i]);
+        }
+    }
+    free(recs);
+    free(outs);
+    scan_drain_results(sc);
+}
+
+/* Check stage over everything queued so far, draining results in batches. */
+static void scan_process(ScanCtx *sc) {
+    if (g_scan_jobs > 1) {
+        scan_process_parallel(sc, g_scan_jobs);
+        return;
+    }
+    char *rec;
+    long n = 0;
+    while ((rec = sq_pop(&sc->work, NULL)) != NULL) {
+        scan_push_result(sc, scan_check(sc, sc->curl, rec));
+        free(rec);
+        if (sc->pending >= SCAN_RESULT_BATCH) scan_drain_results(sc);
+        if (++n % SCAN_CHECK_BATCH == 0) scan_govern(sc, 1);
+    }
+    scan_drain_results(sc);
+}
+
+/* The scan's new last_seen, or -1 if queued runs were lost (last_seen must not move). */
+static long scan_end(ScanCtx *sc) {
+    if (g_mem.transitions || g_mem.evicted || g_mem.pause_ms) {
+        LOG("Memory governor: level=%s transitions=%ld evicted=%ld paused=%ldms",
+            k_mem_names[g_mem.level], g_mem.transitions, g_mem.evicted, g_mem.pause_ms);
+    }
+    for (int j = 0; j < SCAN_MAX_JOBS; j++) if (sc->workers[j]) curl_easy_cleanup(sc->workers[j]);
+    shmap_free(&sc->processedKeys);
+    sq_free(&sc->work);
+    sq_free(&sc->results);
+    if (sc->lost > 0) {
+        /* runs went unchecked: the next run must page them again */
+        LOG("Scan: %ld queued record(s) lost; last_seen stays at %ld", sc->lost, sc->start_seen);
+        return -1;
+    }
+    return sc->new_last_seen;
+}
+
+/*
+   Request planner, run once the feed pages are read: per game, choose how its queued
+   runs get their top-1 answers.
+     per-run  one top=1 leaderboard request per distinct uncached key (the default)
+     sync     the game's records (top=1 of every board without subcategory filters,
+              PLAN_RECORDS_MAX boards a page) loaded into the top-1 cache first, so
+              only keys with variable values still cost a request each
+   Cheap on a quiet hour either way; a game flooding the feed with ILs of plain
+   categories takes one records page instead of a request per level. Board counts
+   per game and the requests the check+history stages really spend per planned
+   check come from earlier runs (data/planner.json). With --request-budget, groups
+   that don't fit what is left are deferred, newest first: their runs leave the queue
+   and last_seen stays below them, so the next run pages and checks them. The group
+   with the oldest run is never deferred, so a game flooding the feed ages into the
+   front of the line instead of being put off until its runs leave the window.
+*/
+#define PLAN_STATS_PATH "data/planner.json"
+#define PLAN_RECORDS_MAX 200
+#define PLAN_SYNC_RETRY_SEC (24 * 3600)      /* after a failed records sync */
+#define PLAN_STATS_KEEP_SEC (30 * 24 * 3600)
+
+static long g_request_budget = 0;           /* --request-budget, 0 = unlimited */
+static cJSON *g_plan_stats = NULL;          /* data/planner.json, saved by wrd_commit */
+
+typedef enum { PLAN_PER_RUN, PLAN_SYNC, PLAN_DEFER } PlanChoice;
+
+typedef struct {
+    const char *game;
+    long runs;                 /* queued runs still to check */
+    long keys, plain_keys;     /* distinct uncached keys; those without variable values */
+    long pages;                /* records pages a sync takes (-1: sync failed lately) */
+    long min_vtime;
+    long checks;               /* top=1 requests left under the chosen strategy */
+    double cost;               /* estimated requests: sync pages + checks with their backfill */
+    PlanChoice choice;
+} PlanGroup;
+
+static const char *const k_plan_names[] = { "per-run", "sync", "defer" };
+
+static cJSON *plan_stats(void) {
+    if (g_plan_stats) return g_plan_stats;
+    char *txt = read_file(PLAN_STATS_PATH);
+    g_plan_stats = txt ? cJSON_Parse(txt) : NULL;
+    free(txt);
+    if (!cJSON_IsObject(g_plan_stats)) {
+        cJSON_Delete(g_plan_stats);
+        g_plan_stats = cJSON_CreateObject();
+    }
+    if (g_plan_stats && !cJSON_IsObject(cJSON_GetObjectItemCaseSensitive(g_plan_stats, "games")))
+        cJSON_AddItemToObject(g_plan_stats, "games", cJSON_CreateObject());
+    return g_plan_stats;
+}
+
+/* Records pages a sync of gameId should take: 1 until one has been seen. */
+static long plan_sync_pages(cJSON *games, const char *gameId, time_t now) {
+    cJSON *g = cJSON_GetObjectItemCaseSensitive(games, gameId);
+    if (!cJSON_IsObject(g)) return 1;
+    long boards = json_get_long(g, "boards", 0);
+    if (boards < 0) return now - json_get_long(g, "at", 0) < PLAN_SYNC_RETRY_SEC ? -1 : 1;
+    return boards > PLAN_RECORDS_MAX ? (boards + PLAN_RECORDS_MAX - 1) / PLAN_RECORDS_MAX : 1;
+}
+
+static void plan_note_sync(cJSON *games, const char *gameId, long boards, time_t now) {
+    cJSON *g = cJSON_CreateObject();
+    if (!g) return;
+    cJSON_AddNumberToObject(g, "boards", (double)boards);
+    cJSON_AddNumberToObject(g, "at", (double)now);
+    if (cJSON_GetObjectItemCaseSensitive(games, gameId)) cJSON_ReplaceItemInObjectCaseSensitive(games, gameId, g);
+    else cJSON_AddItemToObject(games, gameId, g);
+}
+
+/* Load a game's records into the top-1 cache; the board count, or -1 on failure. */
+static long plan_sync_game(ScanCtx *sc, const char *gameId) {
+    long boards = 0;
+    for (int offset = 0; ; offset += PLAN_RECORDS_MAX) {
+        char url[512];
+        snprintf(url, sizeof(url),
+                 "https://www.speedrun.com/api/v1/games/%s/records"
+                 "?top=1&scope=all&skip-empty=true&max=%d&offset=%d",
+                 gameId, PLAN_RECORDS_MAX, offset);
+        char *json = fetch_url(sc->curl, url);
+        cJSON *root = json ? cJSON_Parse(json) : NULL;
+        free(json);
+        cJSON *data = root ? cJSON_GetObjectItemCaseSensitive(root, "data") : NULL;
+        if (!cJSON_IsArray(data)) { cJSON_Delete(root); return -1; }
+
+        int n = 0;
+        cJSON *board = NULL;
+        cJSON_ArrayForEach(board, data) {
+            n++;
+            const char *catId = json_get_string(board, "category");
+            cJSON *runs = cJSON_GetObjectItemCaseSensitive(board, "runs");
+            cJSON *first = cJSON_IsArray(runs) ? cJSON_GetArrayItem(runs, 0) : NULL;
+            cJSON *runObj = first ? cJSON_GetObjectItemCaseSensitive(first, "run") : NULL;
+            const char *topId = cJSON_IsObject(runObj) ? json_get_string(runObj, "id") : NULL;
+            if (!catId || !topId) continue;
+
+            char *key = make_lb_key(gameId, catId, json_get_string(board, "level"),
+                                    cJSON_GetObjectItemCaseSensitive(board, "values"));
+            if (key) lb_cache_put(sc->lbCache, key, topId);
+            free(key);
+        }
+        cJSON_Delete(root);
+        boards += n;
+        if (n < PLAN_RECORDS_MAX) return boards;
+    }
+}
+
+/* Group the work queue by game, price both strategies, fit the budget, run the syncs;
+   returns the top=1 checks left for the check stage. */
+static long scan_plan(ScanCtx *sc, time_t now) {
+    cJSON *stats = plan_stats();
+    cJSON *games = stats ? cJSON_GetObjectItemCaseSensitive(stats, "games") : NULL;
+
+    StrMap byGame;
+    StrSet keys;
+    if (!strmap_init(&byGame, 256)) return 0;
+    if (!strset_init(&keys, 1024)) { strmap_free(&byGame); return 0; }
+    PlanGroup *groups = NULL;
+    int ngroups = 0, capgroups = 0;
+
+    /* pass 1: move the queue aside while counting what each game still has to ask */
+    SpillQueue held;
+    sq_init(&held, "plan");
+    char *rec;
+    size_t len;
+    while ((rec = sq_pop(&sc->work, &len)) != NULL) {
+        scan_push(sc, &held, rec, len);
+        char *f[6];
+        if (scan_fields(rec, f, 6) != 6 || !f[1][0] || !f[2][0] || !f[3][0] ||
+            (shmap_has(sc->runIds, f[1]) &&
+             !(sc->recheck_from > 0 && strtol(f[0], NULL, 10) >= sc->recheck_from))) {
+            free(rec);
+            continue;
+        }
+
+        intptr_t gi = (intptr_t)strmap_get(&byGame, f[2]);
+        if (gi == 0) {
+            if (ngroups == capgroups) {
+                int nc = capgroups ? capgroups * 2 : 64;
+                PlanGroup *ng = realloc(groups, (size_t)nc * sizeof(PlanGroup));
+                if (!ng) { free(rec); continue; }
+                groups = ng;
+                capgroups = nc;
+            }
+            if (!strmap_put(&byGame, f[2], (void *)(intptr_t)(ngroups + 1))) { free(rec); continue; }
+            groups[ngroups] = (PlanGroup){ .min_vtime = LONG_MAX };
+            gi = ++ngroups;
+        }
+        PlanGroup *g = &groups[gi - 1];
+        long vtime = strtol(f[0], NULL, 10);
+        if (vtime < g->min_vtime) g->min_vtime = vtime;
+        g->runs++;
+
+        cJSON *valuesObj = cJSON_Parse(f[5]);
+        char *key = make_lb_key(f[2], f[3], f[4][0] ? f[4] : NULL, valuesObj);
+        if (key && !strset_has(&keys, key) && !shmap_has(sc->lbCache, key)) {
+            strset_add(&keys, key);
+            g->keys++;
+            if (cJSON_GetArraySize(valuesObj) == 0) g->plain_keys++;
+        }
+        free(key);
+        cJSON_Delete(valuesObj);
+        free(rec);
+    }
+    /* strmap keys are stable copies: point the groups at them */
+    for (size_t i = 0; i < byGame.cap; i++) {
+        if (byGame.keys[i]) groups[(intptr_t)byGame.vals[i] - 1].game = byGame.keys[i];
+    }
+
+    /* price: per-run asks every key; sync pays its pages, then asks the keys it can't answer */
+    double per_check = stats ? json_get_number(stats, "requests_per_check", 1.0) : 1.0;
+    if (per_check < 1.0) per_check = 1.0;
+    double planned = 0;
+    long checks = 0;
+    for (int i = 0; i < ngroups; i++) {
+        PlanGroup *g = &groups[i];
+        g->pages = plan_sync_pages(games, g->game, now);
+        int sync = g->pages > 0 && g->pages + (g->keys - g->plain_keys) < g->keys;
+        g->choice = sync ? PLAN_SYNC : PLAN_PER_RUN;
+        g->checks = sync ? g->keys - g->plain_keys : g->keys;
+        g->cost = (sync ? (double)g->pages : 0.0) + (double)g->checks * per_check;
+        planned += g->cost;
+        checks += g->checks;
+    }
+
+    /* budget: defer the groups with the newest runs until the estimate fits */
+    long left = g_request_budget > 0 ? g_request_budget - tx_read(&g_tx.requests) : LONG_MAX;
+    long deferred = 0;
+    while (planned > (double)left) {
+        PlanGroup *worst = NULL, *oldest = NULL;
+        int active = 0;
+        for (int i = 0; i < ngroups; i++) {
+            PlanGroup *g = &groups[i];
+            if (g->choice == PLAN_DEFER) continue;
+            active++;
+            if (!worst || g->min_vtime > worst->min_vtime) worst = g;
+            if (!oldest || g->min_vtime < oldest->min_vtime) oldest = g;
+        }
+        if (active <= 1) {
+            if (oldest) LOG("Plan: game=%s has the oldest runs; checking it over budget", oldest->game);
+            break;
+        }
+        worst->choice = PLAN_DEFER;
+        planned -= worst->cost;
+        checks -= worst->checks;
+        deferred += worst->runs;
+        if (worst->min_vtime < sc->new_last_seen) sc->new_last_seen = worst->min_vtime;
+    }
+
+    long syncs = 0;
+    for (int i = 0; i < ngroups; i++) {
+        PlanGroup *g = &groups[i];
+        LOG("Plan: game=%s runs=%ld keys=%ld plain=%ld pages=%ld -> %s (~%.0f requests)",
+            g->game, g->runs, g->keys, g->plain_keys, g->pages, k_plan_names[g->choice], g->cost);
+        if (g->choice != PLAN_SYNC) continue;
+        syncs++;
+        long boards = plan_sync_game(sc, g->game);
+        if (boards < 0) LOG("Plan: records sync failed for game=%s; checking its runs one by one", g->game);
+        if (games) plan_note_sync(games, g->game, boards, now);
+    }
+    LOG("Plan: groups=%d sync=%ld deferred_runs=%ld checks=%ld est_requests=%.0f budget_left=%ld",
+        ngroups, syncs, deferred, checks, planned, left == LONG_MAX ? -1 : left);
+
+    /* pass 2: requeue everything but the deferred groups' runs */
+    while ((rec = sq_pop(&held, &len)) != NULL) {
+        int keep = 1;
+        if (deferred > 0) {
+            char *tab1 = strchr(rec, '\t');
+            char *tab2 = tab1 ? strchr(tab1 + 1, '\t') : NULL;
+            char *tab3 = tab2 ? strchr(tab2 + 1, '\t') : NULL;
+            if (tab3) {
+                *tab3 = '\0';
+                intptr_t gi = (intptr_t)strmap_get(&byGame, tab2 + 1);
+                keep = gi == 0 || groups[gi - 1].choice != PLAN_DEFER;
+                *tab3 = '\t';
+            }
+        }
+        if (keep) scan_push(sc, &sc->work, rec, len);
+        free(rec);
+    }
+    sq_free(&held);
+
+    /* expire games not synced for a while */
+    if (games) {
+        cJSON *g = games->child;
+        while (g) {
+            cJSON *next = g->next;
+            if (now - json_get_long(g, "at", 0) > PLAN_STATS_KEEP_SEC) cJSON_Delete(cJSON_DetachItemViaPointer(games, g));
+            g = next;
+        }
+    }
+
+    free(groups);
+    strset_free(&keys);
+    strmap_free(&byGame);
+    return checks;
+}
+
+/* Fold the requests the check+history stages spent per planned check into the stats. */
+static void plan_learn(long checks, long spent) {
+    cJSON *stats = plan_stats();
+    if (!stats || checks <= 0) return;
+    double ratio = (double)spent / (double)checks;
+    double prev = json_get_number(stats, "requests_per_check", ratio);
+    double next = 0.7 * prev + 0.3 * ratio;
+    cJSON *v = cJSON_GetObjectItemCaseSensitive(stats, "requests_per_check");
+    if (cJSON_IsNumber(v)) cJSON_SetNumberValue(v, next);
+    else cJSON_AddNumberToObject(stats, "requests_per_check", next);
+}
+
+#define FEED_PAGE_MAX 200
+
+/*
+   The feed is paged by offset while moderators keep verifying (and now and then
+   un-verifying) runs, so pages drift under the walk: new runs on top push later
+   pages down (runs seen twice), removed ones pull them up (runs skipped). Each page
+   is therefore requested FEED_PAGE_OVERLAP runs early and anchored on the previous
+   page's tail ids: everything up to the anchor was read already and is dropped
+   before it is queued, and the anchor's position gives the drift. Drift left after
+   the offset was corrected adds to the correction (never below zero): runs verified
+   at a steady rate push every page by about as much, so later pages are requested
+   that much further down instead of re-reading them. A page that starts below the tail means the shift outran the
+   overlap; the walk steps back a page and re-reads (at most FEED_MAX_BACKUPS times
+   per scan).
+*/
+#define FEED_PAGE_OVERLAP 10
+#define FEED_MAX_BACKUPS 8
+
+typedef struct {
+    char ids[FEED_PAGE_OVERLAP][32];   /* the previous page's last run ids, oldest last */
+    int n;
+    long vtime;                        /* verify time of the oldest */
+} FeedTail;
+
+static void feed_tail_set(FeedTail *t, cJSON *data, int page_n) {
+    t->n = 0;
+    for (int i = page_n > FEED_PAGE_OVERLAP ? page_n - FEED_PAGE_OVERLAP : 0; i < page_n; i++) {
+        cJSON *run = cJSON_GetArrayItem(data, i);
+        const char *id = json_get_string(run, "id");
+        snprintf(t->ids[t->n++], sizeof(t->ids[0]), "%s", id ? id : "");
+        t->vtime = (long)feed_vtime(run);
+    }
+}
+
+/* Index in data of the oldest tail run still present (-1 if none); *drift = how far it moved. */
+static int feed_find_anchor(const FeedTail *t, cJSON *data, int *drift) {
+    for (int j = t->n - 1; j >= 0; j--) {
+        if (!t->ids[j][0]) continue;
+        int i = 0;
+        cJSON *run = NULL;
+        cJSON_ArrayForEach(run, data) {
+            const char *id = json_get_string(run, "id");
+            if (id && strcmp(id, t->ids[j]) == 0) {
+                *drift = i - j;
+                return i;
+            }
+            i++;
+        }
+    }
+    return -1;
+}
+
+static void feed_page_url(char *url, size_t urlsz, int offset) {
+    snprintf(url, urlsz,
+             "https://www.speedrun.com/api/v1/runs"
+             "?status=verified&orderby=verify-date&direction=desc"
+             "&embed=game,category,players,level"
+             "&max=%d&offset=%d",
+             FEED_PAGE_MAX, offset);
+}
+
+/*
+   recheck_from > 0 (store damage) re-tests runs verified since then even when their
+   run_id is already stored: rows lost from the store may belong to their keys.
+   first_page, if not NULL, is the offset=0 body fetched ahead of time (freed here).
+*/
+static long scan_new_runs_and_update(CURL *curl, ShardMap *catCache, ShardMap *lbCache,
+                                     cJSON *wrs, ShardMap *runIds,
+                                     long last_seen_epoch, long recheck_from,
+                                     time_t prune_cutoff_epoch, char *first_page, time_t now) {
+    const int max = FEED_PAGE_MAX;
+    int offset = 0;
+
+    ScanCtx sc;
+    scan_begin(&sc, curl, catCache, lbCache, wrs, runIds, last_seen_epoch, prune_cutoff_epoch);
+    sc.recheck_from = recheck_from;
+
+    const long overlap_sec = 1 * 3600;
+    if (last_seen_epoch > 0) {
+        sc.scan_floor = last_seen_epoch - overlap_sec;
+    } else {
+        sc.scan_floor = (long)prune_cutoff_epoch - overlap_sec;
+    }
+    if (sc.scan_floor < 0) sc.scan_floor = 0;
+
+    long pages = 0, reread = 0, drifts = 0;
+    int backups = 0, ahead = 0;   /* ahead: runs pushed onto the feed per page, as measured */
+    FeedTail tail = { .n = 0 };
+
+    /* feed: page through runs down to scan_floor, queueing candidates */
+    while (1) {
+        pages++;
+        LOG("Runs page: offset=%d max=%d scan_floor=%ld prune_cutoff=%ld last_seen=%ld",
+            offset, max, sc.scan_floor, (long)prune_cutoff_epoch, last_seen_epoch);
+
+        char url[1024];
+        feed_page_url(url, sizeof(url), offset);
+
+        char *json = first_page;
+        first_page = NULL;
+        if (!json) json = fetch_url(curl, url);
+        if (!json) {
+            LOG("Failed to fetch runs page (offset=%d). Stopping.", offset);
+            break;
+        }
+
+        cJSON *root = cJSON_Parse(json);
+        free(json);
+        if (!root) {
+            LOG("Failed to parse runs JSON (offset=%d). Stopping.", offset);
+            break;
+        }
+
+        cJSON *data = cJSON_GetObjectItemCaseSensitive(root, "data");
+        if (!cJSON_IsArray(data)) {
+            LOG("Runs JSON missing data[] (offset=%d). Stopping.", offset);
+            cJSON_Delete(root);
+            break;
+        }
+
+        int page_n = cJSON_GetArraySize(data);
+        if (page_n <= 0) {
+            LOG("Runs page empty (offset=%d). Stopping.", offset);
+            cJSON_Delete(root);
+            break;
+        }
+
+        int skip = 0;
+        if (tail.n > 0) {
+            int drift = 0;
+            int anchor = feed_find_anchor(&tail, data, &drift);
+            if (anchor >= 0) {
+                skip = anchor + 1;
+                ahead += drift;
+                if (ahead < 0) ahead = 0;
+                if (drift != 0) {
+                    drifts++;
+                    LOG("Feed drift at offset=%d: %+d run(s) since the previous page", offset, drift);
+                }
+            } else if ((long)feed_vtime(cJSON_GetArrayItem(data, page_n - 1)) > tail.vtime) {
+                /* pushed down by more than a page: all of it was read already */
+                skip = page_n;
+                LOG("Feed drift at offset=%d: whole page already read", offset);
+            } else if (backups < FEED_MAX_BACKUPS && offset > 0) {
+                backups++;
+                offset -= max - FEED_PAGE_OVERLAP;
+                if (offset < 0) offset = 0;
+                LOG("Feed drift: pulled up past the overlap; re-reading from offset=%d", offset);
+                cJSON_Delete(root);
+                continue;
+            } else {
+                LOG("Feed drift at offset=%d: previous page not found; runs may have been missed", offset);
+            }
+        }
+        reread += skip;
+
+        int stop = scan_queue_page(&sc, data, skip);
+        if (skip < page_n) feed_tail_set(&tail, data, page_n);
+        cJSON_Delete(root);
+        scan_govern(&sc, 1);
+
+        if (stop) {
+            LOG("Stopping scan: reached scan_floor (oldest run < scan_floor)");
+            break;
+        }
+
+        if (page_n < max) break;
+        offset += page_n - FEED_PAGE_OVERLAP + ahead;
+    }
+    if (pages > 1) LOG("Feed: %ld run(s) re-read at page boundaries and dropped, %ld drift(s), %d step(s) back",
+                       reread, drifts, backups);
+
+    /* plan: per-run checks or a records sync per game, within --request-budget */
+    long checks = scan_plan(&sc, now);
+
+    /* check: current-WR test per queued run; history: backfill each new key */
+    long before = tx_read(&g_tx.requests);
+    scan_process(&sc);
+    plan_learn(checks, tx_read(&g_tx.requests) - before);
+
+    LOG("Scan complete: pages=%ld seen=%ld checked=%ld keys_processed=%ld new_last_seen=%ld",
+        pages, sc.runs_seen, sc.runs_checked, sc.keys_processed, sc.new_last_seen);
+
+    return scan_end(&sc);
+}
+
+/* ----------------- README rendering (only Subcategories truncated) ----------------- */
+
+static void fputs_html_escaped(FILE *fp, const char *s) {
+    if (!s) return;
+    size_t n = strlen(s);
+    size_t i = 0;
+    while (i < n) {
+        /* copy the clean run in one go, then escape the byte that stopped it */
+        size_t run = g_isa->html_run(s + i, n - i);
+        if (run) fwrite(s + i, 1, run, fp);
+        i += run;
+        if (i >= n) break;
+
+        const unsigned char *p = (const unsigned char*)s + i++;
+        switch (*p) {
+            case '&': fputs("&amp;", fp); break;
+            case '<': fputs("&lt;", fp); break;
+            case '>': fputs("&gt;", fp); break;
+            case '"': fputs("&quot;", fp); break;
+            case '\'': fputs("&#39;", fp); break;
+            case '|': fputs("&#124;", fp); break;
+            case '\n': case '\r': case '\t': fputc(' ', fp); break;
+            default: fputc(*p, fp); break;
+        }
+    }
+}
+
+static void print_cell_plain_sub(FILE *out, const char *s) {
+    fprintf(out, "<sub>");
+    fputs_html_escaped(out, s ? s : "");
+    fprintf(out, "</sub>");
+}
+
+static void print_cell_subcat_trunc(FILE *out, const char *s, int max_chars) {
+    if (!s) s = "";
+    int n = (int)strlen(s);
+    int trunc = (max_chars > 0 && n > max_chars);
+
+    fprintf(out, "<sub><span title=\"");
+    fputs_html_escaped(out, s);
+    fprintf(out, "\">");
+
+    if (!trunc || max_chars <= 0) {
+        fputs_html_escaped(out, s);
+    } else {
+        int take = max_chars - 1;
+        if (take < 0) take = 0;
+
+        int end = take;
+        while (end > 0) {
+            unsigned char c = (unsigned char)s[end];
+            if ((c & 0xC0) != 0x80) break;
+            end--;
+        }
+        if (end <= 0) end = take;
+
+        for (int i = 0; i < end && s[i]; i++) {
+            char tmp[2] = { s[i], 0 };
+            fputs_html_escaped(out, tmp);
+        }
+        fprintf(out, "…");
+    }
+
+    fprintf(out, "</span></sub>");
+}
+
+/* Game cell: image + <br/> + title */
+static void print_game_cell_with_cover(FILE *out, const char *game_name, const char *cover_uri_maybe) {
+    if (!game_name) game_name = "";
+
+    char cover_norm[1024];
+    cover_norm[0] = '\0';
+    if (cover_uri_maybe && cover_uri_maybe[0]) {
+        normalize_cover_uri(cover_uri_maybe, cover_norm, sizeof(cover_norm));
+    }
+
+    fprintf(out, "<div style=\"text-align:center;\">");
+
+    if (cover_norm[0]) {
+        fprintf(out, "<img src=\"");
+        fputs_html_escaped(out, cover_norm);
+        fprintf(out, "\" alt=\"\" width=\"60\" style=\"display:block; margin:0 auto 4px auto;\"/>");
+        fprintf(out, "<br/>");
+    } else {
+        fprintf(out, "<br/>");
+    }
+
+    fprintf(out, "<sub>");
+    fputs_html_escaped(out, game_name);
+    fprintf(out, "</sub>");
+
+    fprintf(out, "</div>");
+}
+
+/* Runner(s) cell: avatars + <br/> + names */
+static void print_runners_cell_with_avatars(FILE *out, cJSON *players_data, const char *fallback_names) {
+    if (!cJSON_IsArray(players_data) || cJSON_GetArraySize(players_data) <= 0) {
+        print_cell_plain_sub(out, fallback_names ? fallback_names : "");
+        return;
+    }
+
+    fprintf(out, "<div style=\"display:flex; gap:6px; justify-content:center; align-items:flex-start;\">");
+
+    int n = cJSON_GetArraySize(players_data);
+    for (int i = 0; i < n; i++) {
+        cJSON *p = cJSON_GetArrayItem(players_data, i);
+        if (!cJSON_IsObject(p)) continue;
+
+        const char *name = json_get_string(p, "name");
+        const char *img  = json_get_string(p, "image");
+        const char *link = json_get_string(p, "weblink");
+
+        if (!name) name = "unknown";
+        if (!img) img = "";
+        if (!link) link = "";
+
+        fprintf(out, "<div style=\"text-align:center;\">");
+
+        if (img[0]) {
+            if (link[0]) {
+                fprintf(out, "<a href=\"");
+                fputs_html_escaped(out, link);
+                fprintf(out, "\">");
+            }
+
+            fprintf(out, "<img src=\"");
+            fputs_html_escaped(out, img);
+            fprintf(out, "\" alt=\"\" width=\"40\" style=\"display:block; margin:0 auto 4px auto; border-radius:50%%;\"/>");
+
+            if (link[0]) fprintf(out, "</a>");
+            fprintf(out, "<br/>");
+        } else {
+            fprintf(out, "<br/>");
+        }
+
+        fprintf(out, "<sub>");
+        fputs_html_escaped(out, name);
+        fprintf(out, "</sub>");
+
+        fprintf(out, "</div>");
+    }
+
+    fprintf(out, "</div>");
+}
+
+static void print_section_from_wrs(FILE *out, const char *title, const WrView *view, time_t cutoff_epoch) {
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    WR_PROBE(render_start, title, (long)cutoff_epoch);
+
+    fprintf(out, "### %s\n\n", title);
+
+    fprintf(out, "| <sub>When (ET)</sub> | <sub>Game</sub> | <sub>Category</sub> | <sub>Subcategory</sub> | <sub>Level</sub> | <sub>Time</sub> | <sub>Runner(s)</sub> | <sub>Link</sub> |\n");
+    fprintf(out, "|---|---|---|---|---|---:|---|---|\n");
+
+    /* the view is newest first, so the section is a prefix of it */
+    int printed = 0;
+    int limit = view_count_since(view, cutoff_epoch);
+    cJSON *it = view ? view->rows->child : NULL;
+    for (; it && printed < limit; it = it->next) {
+        long v = view->epochs[printed];
+
+        const char *game = json_get_string(it, "game");
+        const char *game_cover = json_get_string(it, "game_cover");
+        const char *cat = json_get_string(it, "category");
+        const char *sub = json_get_string(it, "subcats");
+        const char *lvl = json_get_string(it, "level");
+        const char *players = json_get_string(it, "players");
+        cJSON *players_data = cJSON_GetObjectItemCaseSensitive(it, "players_data");
+        const char *link = json_get_string(it, "weblink");
+        double t = json_get_number(it, "primary_t", -1);
+
+        char tbuf[64];
+        format_seconds(t, tbuf, sizeof(tbuf));
+
+        char when_buf[64];
+        format_pretty_et((time_t)v, when_buf, sizeof(when_buf));
+
+        fprintf(out, "| ");
+        print_cell_plain_sub(out, when_buf);
+        fprintf(out, " | ");
+        print_game_cell_with_cover(out, game ? game : "", (game_cover && game_cover[0]) ? game_cover : NULL);
+        fprintf(out, " | ");
+        print_cell_plain_sub(out, cat ? cat : "");
+        fprintf(out, " | ");
+        print_cell_subcat_trunc(out, (sub && sub[0]) ? sub : "", 20);
+        fprintf(out, " | ");
+        print_cell_plain_sub(out, (lvl && lvl[0]) ? lvl : "");
+        fprintf(out, " | <sub>");
+        fputs_html_escaped(out, tbuf);
+        fprintf(out, "</sub> | ");
+
+        print_runners_cell_with_avatars(out, players_data, players ? players : "");
+
+        fprintf(out, " | ");
+
+        if (link && link[0]) {
+            fprintf(out, "<sub><a href=\"");
+            fputs_html_escaped(out, link);
+            fprintf(out, "\">link</a></sub>");
+        } else {
+            fprintf(out, "<sub>&nbsp;</sub>");
+        }
+
+        fprintf(out, " |\n");
+        printed++;
+    }
+
+    if (printed == 0) {
+        fprintf(out, "| <sub>—</sub> | <em>None</em> |  |  |  |  |  |  |\n");
+    }
+
+    fprintf(out, "\n");
+    WR_PROBE(render_done, title, printed, elapsed_us_since(&t0));
+}
+
+typedef struct {
+    time_t cutoff_1h, cutoff_24h;
+    char *md;
+    size_t md_len;
+    int rows;
+    ThreadPhase phase;        /* measured on the render thread */
+} RenderJob;
+
+/* Reader thread: pins the published view and renders the README sections to memory. */
+static void *render_thread(void *arg) {
+    RenderJob *job = (RenderJob *)arg;
+    thread_phase_begin(&job->phase);
+
+    FILE *out = open_memstream(&job->md, &job->md_len);
+    if (!out) { thread_phase_end(&job->phase); return NULL; }
+
+    const WrView *view = NULL;
+    int slot = view_pin(&view);
+    fprintf(out, "## 🏁 Live #1 Records\n\n");
+    fprintf(out, "_Updated hourly via GitHub Actions._\n\n");
+    print_section_from_wrs(out, "Past hour", view, job->cutoff_1h);
+    print_section_from_wrs(out, "Past 24 hours", view, job->cutoff_24h);
+    job->rows = view ? view->n : 0;
+    view_unpin(slot);
+
+    fclose(out);
+    thread_phase_end(&job->phase);
+    return NULL;
+}
+
+/* Upgrade existing recent wrs.json entries (within cutoff) with players_data so avatars show immediately */
+static void enrich_recent_entries_with_players_data(CURL *curl, cJSON *wrs, time_t cutoff_epoch) {
+    if (!cJSON_IsArray(wrs)) return;
+
+    cJSON *it = NULL;
+    cJSON_ArrayForEach(it, wrs) {
+        if (!cJSON_IsObject(it)) continue;
+
+        long v = json_get_long(it, "verified_epoch", 0);
+        if ((time_t)v < cutoff_epoch) continue;
+
+        if (cJSON_GetObjectItemCaseSensitive(it, "players_data")) continue;
+
+        const char *rid = json_get_string(it, "run_id");
+        if (!rid || !rid[0]) continue;
+
+        cJSON *runFull = fetch_run_details(curl, rid, 1, NULL);
+        if (!runFull) continue;
+
+        cJSON *arr = build_players_array(runFull);
+        cJSON_Delete(runFull);
+
+        if (arr) {
+            cJSON_AddItemToObject(it, "players_data", arr);
+            changes_record("enrich", rid, it);
+        }
+
+        pace_sleep(2000);
+    }
+}
+
+/* ----------------- caching reverse proxy (wr_daily proxy) ----------------- */
+
+/*
+   wr_daily proxy [--listen=HOST:PORT] [--cache=DIR] [--interval=MS]
+   Serves GET /api/v1/... from an on-disk cache and forwards misses to
+   speedrun.com via fetch_url() (same retries/backoff). Cache files use the
+   --record layout (DIR/<fnv1a_64(url)>.json + index.tsv), so a proxy cache can be
+   replayed directly. Freshness is the file mtime against a per-endpoint TTL;
+   identical concurrent misses share one upstream request, upstream requests are
+   spaced at least --interval apart, and an expired entry is served (X-Cache: STALE)
+   when upstream fails.
+   An upstream 404 is passed through and cached like a body, as an empty
+   DIR/<hash>.404 marker (a replay of the cache sees no file: a 404 too).
+   One request per connection, thread per connection.
+   Point wr_daily at it with --api=http://HOST:PORT.
+*/
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <signal.h>
+
+typedef struct { const char *prefix; int ttl_sec; } ProxyTtl;
+
+/* first match wins; prefixes are relative to /api/v1/ */
+static const ProxyTtl k_proxy_ttls[] = {
+    { "runs?",       60 },        /* the verified-runs feed moves constantly */
+    { "runs/",       6 * 3600 },  /* a run's details rarely change once verified */
+    { "leaderboards/", 300 },
+    { "categories/", 24 * 3600 }, /* variables */
+    { "games/",      24 * 3600 },
+    { "",            300 },
+};
+
+typedef struct ProxyFlight {
+    char *url;
+    int done;
+    char *body;    /* NULL: upstream failed */
+    long status;   /* upstream's final status (404 passes through) */
+    int waiters;   /* threads still holding this flight */
+    struct ProxyFlight *next;
+} ProxyFlight;
+
+static const char *g_proxy_cache_dir = "data/proxy-cache";
+static long g_proxy_interval_ms = 1000;
+static pthread_mutex_t g_proxy_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_proxy_cond = PTHREAD_COND_INITIALIZER;
+static ProxyFlight *g_proxy_flights = NULL;
+static pthread_mutex_t g_proxy_pace_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct timespec g_proxy_last_upstream;
+
+static int proxy_ttl_for(const char *api_path) {
+    for (size_t i = 0; i < sizeof(k_proxy_ttls) / sizeof(k_proxy_ttls[0]); i++) {
+        if (strncmp(api_path, k_proxy_ttls[i].prefix, strlen(k_proxy_ttls[i].prefix)) == 0) {
+            return k_proxy_ttls[i].ttl_sec;
+        }
+    }
+    return 300;
+}
+
+/* Hold upstream calls to one every g_proxy_interval_ms across all threads. */
+static void proxy_pace(void) {
+    pthread_mutex_lock(&g_proxy_pace_lock);
+    if (g_proxy_last_upstream.tv_sec || g_proxy_last_upstream.tv_nsec) {
+        long waited_us = elapsed_us_since(&g_proxy_last_upstream);
+        long need_us = g_proxy_interval_ms * 1000L - waited_us;
+        if (need_us > 0) usleep((useconds_t)need_us);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &g_proxy_last_upstream);
+    pthread_mutex_unlock(&g_proxy_pace_lock);
+}
+
+/* Write-then-rename so concurrent readers never see a partial cache file. */
+static void proxy_cache_store(const char *url, const char *path, const char *body) {
+    char tmp[1100];
+    snprintf(tmp, sizeof(tmp), "%s.%lx.tmp", path, (unsigned long)pthread_self());
+    int is_new = access(path, F_OK) != 0;
+    if (!write_file(tmp, body) || rename(tmp, path) != 0) { unlink(tmp); return; }
+    if (!is_new) return;
+
+    char idx[1024];
+    snprintf(idx, sizeof(idx), "%s/index.tsv", g_proxy_cache_dir);
+    pthread_mutex_lock(&g_proxy_lock);
+    FILE *f = fopen(idx, "ab");
+    if (f) {
+        fprintf(f, "%016llx\t%s\n", (unsigned long long)fnv1a_64(url), url);
+        fclose(f);
+    }
+    pthread_mutex_unlock(&g_proxy_lock);
+}
+
+/* path with its .json swapped for .404: the marker of a cached upstream 404 */
+static void proxy_404_path(const char *path, char *out, size_t outsz) {
+    size_t n = strlen(path);
+    if (n > 5) n -= 5;
+    snprintf(out, outsz, "%.*s.404", (int)n, path);
+}
+
+static void proxy_cache_store_404(const char *path) {
+    char marker[1100];
+    proxy_404_path(path, marker, sizeof(marker));
+    if (!write_file(marker, "")) LOG("proxy: cannot write %s", marker);
+}
+
+/* Fetch upstream, or wait for the thread already fetching the same URL. */
+static char *proxy_fetch_coalesced(const char *url, const char *path, int *coalesced, long *status) {
+    pthread_mutex_lock(&g_proxy_lock);
+    ProxyFlight *fl = g_proxy_flights;
+    while (fl && strcmp(fl->url, url) != 0) fl = fl->next;
+
+    if (fl) {
+        *coalesced = 1;
+        fl->waiters++;
+        while (!fl->done) pthread_cond_wait(&g_proxy_cond, &g_proxy_lock);
+        char *body = fl->body ? strdup(fl->body) : NULL;
+        *status = fl->status;
+        if (--fl->waiters == 0) { free(fl->url); free(fl->body); free(fl); }
+        pthread_mutex_unlock(&g_proxy_lock);
+        return body;
+    }
+
+    *coalesced = 0;
+    fl = (ProxyFlight *)calloc(1, sizeof(ProxyFlight));
+    if (!fl || !(fl->url = strdup(url))) { free(fl); pthread_mutex_unlock(&g_proxy_lock); return NULL; }
+    fl->waiters = 1;
+    fl->next = g_proxy_flights;
+    g_proxy_flights = fl;
+    pthread_mutex_unlock(&g_proxy_lock);
+
+    char *body = NULL;
+    *status = 0;
+    CURL *curl = curl_easy_init();
+    if (curl) {
+        proxy_pace();
+        body = fetch_url_from(curl, url, __func__, status);
+        curl_easy_cleanup(curl);
+    }
+    if (body) proxy_cache_store(url, path, body);
+    else if (*status == 404) proxy_cache_store_404(path);
+
+    pthread_mutex_lock(&g_proxy_lock);
+    for (ProxyFlight **pp = &g_proxy_flights; *pp; pp = &(*pp)->next) {
+        if (*pp == fl) { *pp = fl->next; break; }
+    }
+    fl->body = body ? strdup(body) : NULL;
+    fl->status = *status;
+    fl->done = 1;
+    pthread_cond_broadcast(&g_proxy_cond);
+    if (--fl->waiters == 0) { free(fl->url); free(fl->body); free(fl); }
+    pthread_mutex_unlock(&g_proxy_lock);
+    return body;
+}
+
+static void proxy_send(int fd, int code, const char *reason, const char *cache, const char *body, size_t len) {
+    char hdr[256];
+    int n = snprintf(hdr, sizeof(hdr),
+                     "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n"
+                     "X-Cache: %s\r\nConnection: close\r\n\r\n", code, reason, len, cache);
+    const char *parts[2] = { hdr, body };
+    size_t lens[2] = { (size_t)n, len };
+    for (int i = 0; i < 2; i++) {
+        size_t off = 0;
+        while (off < lens[i]) {
+            ssize_t w = send(fd, parts[i] + off, lens[i] - off, MSG_NOSIGNAL);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) return;
+            off += (size_t)w;
+        }
+    }
+}
+
+static void *proxy_conn_thread(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    char req[8192];
+    size_t got = 0;
+    while (got < sizeof(req) - 1) {
+        ssize_t r = recv(fd, req + got, sizeof(req) - 1 - got, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) break;
+        got += (size_t)r;
+        req[got] = '\0';
+        if (strstr(req, "\r\n\r\n")) break;
+    }
+    req[got] = '\0';
+
+    char method[8], target[4096];
+    if (sscanf(req, "%7s %4095s HTTP/1.", method, target) != 2) {
+        proxy_send(fd, 400, "Bad Request", "NONE", "", 0);
+    } else if (strcmp(method, "GET") != 0) {
+        proxy_send(fd, 405, "Method Not Allowed", "NONE", "", 0);
+    } else if (strncmp(target, "/api/v1/", 8) != 0) {
+        proxy_send(fd, 404, "Not Found", "NONE", "", 0);
+    } else {
+        char url[4200];
+        snprintf(url, sizeof(url), API_ORIGIN "%s", target);
+        char path[1024];
+        replay_file_path(g_proxy_cache_dir, url, path, sizeof(path));
+
+        char marker[1100];
+        proxy_404_path(path, marker, sizeof(marker));
+
+        struct stat st;
+        int ttl = proxy_ttl_for(target + 8);
+        int cached = stat(path, &st) == 0;
+        int fresh = cached && time(NULL) - st.st_mtime < ttl;
+        int gone = !fresh && stat(marker, &st) == 0 && time(NULL) - st.st_mtime < ttl;
+        char *body = fresh ? read_file(path) : NULL;
+        long status = gone ? 404 : 200;
+        const char *how = "HIT";
+        if (!body && !gone) {
+            int coalesced = 0;
+            body = proxy_fetch_coalesced(url, path, &coalesced, &status);
+            how = coalesced ? "COALESCED" : "MISS";
+            if (!body && status != 404 && cached && (body = read_file(path)) != NULL) how = "STALE";
+        }
+        if (body) proxy_send(fd, 200, "OK", how, body, strlen(body));
+        else if (status == 404) proxy_send(fd, 404, "Not Found", how, "", 0);
+        else proxy_send(fd, 502, "Bad Gateway", how, "", 0);
+        LOG("proxy %s %s", how, target);
+        free(body);
+    }
+
+    close(fd);
+    return NULL;
+}
+
+int wrd_proxy(const wrd_proxy_options *opts) {
+    const char *listen_spec = opts && opts->listen ? opts->listen : "127.0.0.1:8787";
+    if (opts && opts->cache_dir) g_proxy_cache_dir = opts->cache_dir;
+    if (opts && opts->interval_ms < 0) {
+        fprintf(stderr, "bad interval: %ld\n", opts->interval_ms);
+        return WRD_EUSAGE;
+    }
+    if (opts && opts->interval_ms > 0) g_proxy_interval_ms = opts->interval_ms;
+    if (opts && opts->replay_dir) g_replay_dir = opts->replay_dir; /* upstream from a replay dir (testing) */
+
+    char host[64];
+    int port = 0;
+    if (sscanf(listen_spec, "%63[^:]:%d", host, &port) != 2 || port <= 0 || port > 65535) {
+        fprintf(stderr, "bad listen address: %s\n", listen_spec);
+        return WRD_EUSAGE;
+    }
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host, &sa.sin_addr) != 1) {
+        fprintf(stderr, "bad listen address: %s\n", host);
+        return WRD_EUSAGE;
+    }
+
+    init_debug_from_env();
+    if (!ensure_dir(g_proxy_cache_dir)) {
+        fprintf(stderr, "Failed to ensure %s\n", g_proxy_cache_dir);
+        return WRD_ERR;
+    }
+
+    int ls = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    if (ls < 0 || setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(ls, (struct sockaddr *)&sa, sizeof(sa)) != 0 || listen(ls, 64) != 0) {
+        fprintf(stderr, "cannot listen on %s: %s\n", listen_spec, strerror(errno));
+        if (ls >= 0) close(ls);
+        return WRD_ERR;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    LOG("Proxy listening on %s, cache=%s, upstream interval=%ldms", listen_spec, g_proxy_cache_dir,
+        g_proxy_interval_ms);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (;;) {
+        int fd = accept4(ls, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            LOG("proxy accept: %s", strerror(errno));
+            break;
+        }
+        struct timeval tv = { .tv_sec = 30, .tv_usec = 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        pthread_t t;
+        if (pthread_create(&t, &attr, proxy_conn_thread, (void *)(intptr_t)fd) != 0) close(fd);
+    }
+
+    pthread_attr_destroy(&attr);
+    close(ls);
+    curl_global_cleanup();
+    return WRD_ERR;
+}
+
+/* ----------------- external sort of WR rows (wr_daily sort) ----------------- */
+
+/*
+   Sorts a WR dump of any size into the view's order (verified_epoch desc, run_id asc)
+   within a fixed memory budget, for imports and long-retention stores:
+     1. stream the input (a JSON array of rows or one row per line), fill the budget
+        with compact rows, sort them and write a run to an unlinked temp file;
+     2. merge up to XS_FANIN runs at a time through a loser tree (one comparison per
+        tree level per row), repeating until one pass can produce the output;
+     3. the last pass streams a flat wrs.json array, which load_wrs_array() reads as rows.
+   Run records are <int64 epoch><u16 id len><u32 row len><id><row>, so merging never
+   re-parses JSON and every pass is a sequential read + sequential write.
+*/
+
+#define XS_FANIN 64
+
+int wrd_parse_size(const char *s, size_t *out) {
+    char *end = NULL;
+    long long v = strtoll(s, &end, 10);
+    if (!end || end == s || v <= 0) return 0;
+    if (*end == 'k' || *end == 'K') { v <<= 10; end++; }
+    else if (*end == 'm' || *end == 'M') { v <<= 20; end++; }
+    else if (*end == 'g' || *end == 'G') { v <<= 30; end++; }
+    if (*end) return 0;
+    *out = (size_t)v;
+    return 1;
+}
+
+typedef struct {
+    long epoch;
+    size_t off;       /* id, then row text, in the arena */
+    uint32_t len;
+    uint16_t idlen;
+} XsRec;
+
+typedef struct {
+    FILE *f;
+    int live;
+    long epoch;
+    char *id, *row;
+    uint32_t len;
+    uint16_t idlen;
+    size_t idcap, rowcap;
+    char *iobuf;
+} XsRun;
+
+typedef struct {
+    size_t budget;
+    Buffer arena;
+    XsRec *recs;
+    size_t n, cap;
+    FILE **runs;
+    int nruns, runcap;
+    long rows, skipped, passes;
+    unsigned long long bytes_written;
+} XsSort;
+
+static int xs_rec_cmp(const void *a, const void *b, void *arg) {
+    const XsRec *ra = (const XsRec*)a;
+    const XsRec *rb = (const XsRec*)b;
+    if (ra->epoch > rb->epoch) return -1;
+    if (ra->epoch < rb->epoch) return 1;
+    const char *base = (const char*)arg;
+    uint16_t n = ra->idlen < rb->idlen ? ra->idlen : rb->idlen;
+    int c = memcmp(base + ra->off, base + rb->off, n);
+    if (c) return c;
+    return (int)ra->idlen - (int)rb->idlen;
+}
+
+static int xs_write_rec(FILE *f, long epoch, const char *id, uint16_t idlen, const char *row, uint32_t len) {
+    int64_t e = epoch;
+    return fwrite(&e, sizeof(e), 1, f) == 1 && fwrite(&idlen, sizeof(idlen), 1, f) == 1 &&
+           fwrite(&len, sizeof(len), 1, f) == 1 && fwrite(id, 1, idlen, f) == idlen &&
+           fwrite(row, 1, len, f) == len;
+}
+
+/* Sort what is buffered and write it out as one run. */
+static int xs_spill(XsSort *xs) {
+    if (xs->n == 0) return 1;
+    qsort_r(xs->recs, xs->n, sizeof(XsRec), xs_rec_cmp, xs->arena.data);
+
+    FILE *f = tmpfile();
+    if (!f) { LOG("sort: tmpfile: %s", strerror(errno)); return 0; }
+    for (size_t i = 0; i < xs->n; i++) {
+        const XsRec *r = &xs->recs[i];
+        const char *id = xs->arena.data + r->off;
+        if (!xs_write_rec(f, r->epoch, id, r->idlen, id + r->idlen, r->len)) {
+            LOG("sort: run write failed: %s", strerror(errno));
+            fclose(f);
+            return 0;
+        }
+        xs->bytes_written += sizeof(int64_t) + sizeof(uint16_t) + sizeof(uint32_t) + r->idlen + r->len;
+    }
+    if (fflush(f) != 0) { fclose(f); return 0; }
+
+    if (xs->nruns == xs->runcap) {
+        int nc = xs->runcap ? xs->runcap * 2 : 16;
+        FILE **p = realloc(xs->runs, (size_t)nc * sizeof(FILE*));
+        if (!p) { fclose(f); return 0; }
+        xs->runs = p;
+        xs->runcap = nc;
+    }
+    xs->runs[xs->nruns++] = f;
+    xs->n = 0;
+    xs->arena.size = 0;
+    return 1;
+}
+
+/* Buffer one parsed row, spilling first if it would overflow the budget. */
+static int xs_add(XsSort *xs, cJSON *row) {
+    const char *id = json_get_string(row, "run_id");
+    cJSON *ve = cJSON_GetObjectItemCaseSensitive(row, "verified_epoch");
+    if (!id || !cJSON_IsNumber(ve) || strlen(id) > UINT16_MAX) { xs->skipped++; return 1; }
+
+    char *txt = cJSON_PrintUnformatted(row);
+    if (!txt) return 0;
+    size_t idlen = strlen(id), len = strlen(txt);
+
+    size_t need = xs->arena.size + idlen + len + (xs->n + 1) * sizeof(XsRec);
+    if (need > xs->budget && xs->n > 0 && !xs_spill(xs)) { free(txt); return 0; }
+
+    if (xs->n == xs->cap) {
+        size_t nc = xs->cap ? xs->cap * 2 : 1024;
+        XsRec *p = realloc(xs->recs, nc * sizeof(XsRec));
+        if (!p) { free(txt); return 0; }
+        xs->recs = p;
+        xs->cap = nc;
+    }
+    XsRec *r = &xs->recs[xs->n++];
+    r->epoch = (long)ve->valuedouble;
+    r->off = xs->arena.size;
+    r->idlen = (uint16_t)idlen;
+    r->len = (uint32_t)len;
+    int ok = buf_append(&xs->arena, id, idlen) && buf_append(&xs->arena, txt, len);
+    free(txt);
+    xs->rows++;
+    return ok;
+}
+
+/*
+   Feed top-level objects from `in` to xs_add: either the elements of one JSON array
+   or a sequence of objects (JSONL). Only the current object is held in memory.
+*/
+static int xs_read_input(XsSort *xs, FILE *in) {
+    char chunk[1 << 16];
+    Buffer obj = {0};
+    int depth = 0, in_str = 0, esc = 0, ok = 1;
+    size_t got;
+    while (ok && (got = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        size_t start = 0;
+        for (size_t i = 0; i < got; i++) {
+            char c = chunk[i];
+            if (depth == 0) {
+                if (c == '{') { depth = 1; start = i; }
+                continue; /* whitespace, commas, the outer [ ] */
+            }
+            if (in_str) {
+                if (esc) esc = 0;
+                else if (c == '\\') esc = 1;
+                else if (c == '"') in_str = 0;
+                continue;
+            }
+            if (c == '"') in_str = 1;
+            else if (c == '{' || c == '[') depth++;
+            else if ((c == '}' || c == ']') && --depth == 0) {
+                if (!buf_append(&obj, chunk + start, i + 1 - start)) { ok = 0; break; }
+                cJSON *row = cJSON_Parse(obj.data);
+                if (cJSON_IsObject(row)) ok = xs_add(xs, row);
+                else xs->skipped++;
+                cJSON_Delete(row);
+                obj.size = 0;
+            }
+        }
+        if (ok && depth > 0 && !buf_append(&obj, chunk + start, got - start)) ok = 0;
+    }
+    if (ferror(in)) ok = 0;
+    if (depth > 0) LOG("sort: input ends inside an object; dropped it");
+    free(obj.data);
+    return ok;
+}
+
+static int xs_run_next(XsRun *r) {
+    int64_t e;
+    if (fread(&e, sizeof(e), 1, r->f) != 1 || fread(&r->idlen, sizeof(r->idlen), 1, r->f) != 1 ||
+        fread(&r->len, sizeof(r->len), 1, r->f) != 1) {
+        r->live = 0;
+        return 0;
+    }
+    if (r->idlen + 1u > r->idcap) {
+        char *p = realloc(r->id, r->idlen + 1u);
+        if (!p) { r->live = 0; return 0; }
+        r->id = p;
+        r->idcap = r->idlen + 1u;
+    }
+    if ((size_t)r->len + 1 > r->rowcap) {
+        char *p = realloc(r->row, (size_t)r->len + 1);
+        if (!p) { r->live = 0; return 0; }
+        r->row = p;
+        r->rowcap = (size_t)r->len + 1;
+    }
+    if (fread(r->id, 1, r->idlen, r->f) != r->idlen || fread(r->row, 1, r->len, r->f) != r->len) {
+        r->live = 0;
+        return 0;
+    }
+    r->epoch = (long)e;
+    r->live = 1;
+    return 1;
+}
+
+/* Does run a's head come out before run b's? Exhausted runs lose to everything. */
+static int xs_before(const XsRun *a, const XsRun *b) {
+    if (!a->live) return 0;
+    if (!b->live) return 1;
+    if (a->epoch != b->epoch) return a->epoch > b->epoch;
+    uint16_t n = a->idlen < b->idlen ? a->idlen : b->idlen;
+    int c = memcmp(a->id, b->id, n);
+    return c ? c < 0 : a->idlen < b->idlen;
+}
+
+/*
+   Loser tree: leaves are runs k..2k-1, tree[1..k-1] hold the loser of each match and
+   tree[0] the overall winner. Replaying from a leaf costs one comparison per level.
+   A slot of -1 is only seen while building: the first arrival waits there.
+*/
+static void lt_replay(int *tree, const XsRun *runs, int k, int s) {
+    for (int t = (s + k) / 2; t > 0; t /= 2) {
+        if (tree[t] < 0) { tree[t] = s; return; }
+        if (xs_before(&runs[tree[t]], &runs[s])) { int w = tree[t]; tree[t] = s; s = w; }
+    }
+    tree[0] = s;
+}
+
+/*
+   Merge runs[0..k) (rewound) through a loser tree. With `out_json` the rows go out as
+   a JSON array, otherwise as one run file in the temp format (returned via *merged).
+*/
+static int xs_merge(XsSort *xs, FILE **files, int k, FILE *out_json, FILE **merged) {
+    XsRun *runs = calloc((size_t)k, sizeof(XsRun));
+    int *tree = malloc((size_t)k * sizeof(int));
+    /* split the budget into read buffers so each pass is a few large sequential reads */
+    size_t bufsz = xs->budget / (size_t)(k + 1);
+    if (bufsz < (64u << 10)) bufsz = 64u << 10;
+    if (!runs || !tree) { free(runs); free(tree); return 0; }
+
+    FILE *dst = out_json;
+    if (!dst) {
+        dst = tmpfile();
+        if (!dst) { free(runs); free(tree); return 0; }
+    }
+
+    for (int i = 0; i < k; i++) {
+        runs[i].f = files[i];
+        rewind(files[i]);
+        runs[i].iobuf = malloc(bufsz);
+        if (runs[i].iobuf) setvbuf(files[i], runs[i].iobuf, _IOFBF, bufsz);
+        xs_run_next(&runs[i]);
+        tree[i] = -1;
+    }
+    for (int i = 0; i < k; i++) lt_replay(tree, runs, k, i);
+
+    int ok = 1;
+    long emitted = 0;
+    if (out_json) ok = fputs("[\n", dst) >= 0;
+    while (ok && runs[tree[0]].live) {
+        XsRun *w = &runs[tree[0]];
+        if (out_json) {
+            ok = (emitted ? fputs(",\n", dst) >= 0 : 1) && fwrite(w->row, 1, w->len, dst) == w->len;
+        } else {
+            ok = xs_write_rec(dst, w->epoch, w->id, w->idlen, w->row, w->len);
+            xs->bytes_written += sizeof(int64_t) + sizeof(uint16_t) + sizeof(uint32_t) + w->idlen + w->len;
+        }
+        emitted++;
+        xs_run_next(w);
+        lt_replay(tree, runs, k, tree[0]);
+    }
+    if (ok && out_json) ok = fputs(emitted ? "\n]\n" : "]\n", dst) >= 0;
+    if (ok) ok = fflush(dst) == 0;
+
+    for (int i = 0; i < k; i++) {
+        fclose(runs[i].f);
+        free(runs[i].iobuf);
+        free(runs[i].id);
+        free(runs[i].row);
+    }
+    free(runs);
+    free(tree);
+
+    if (!out_json) {
+        if (ok) *merged = dst;
+        else fclose(dst);
+    }
+    return ok;
+}
+
+int wrd_sort(FILE *in, FILE *out, size_t mem_budget) {
+    XsSort xs = { .budget = mem_budget ? mem_budget : 64u << 20 };
+
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int ok = xs_read_input(&xs, in);
+    /* everything fit in the budget: no runs, sort in place below */
+    if (ok && xs.nruns > 0) ok = xs_spill(&xs);
+    int initial_runs = xs.nruns;
+
+    /* intermediate passes until the final merge fits in one loser tree */
+    while (ok && xs.nruns > XS_FANIN) {
+        int next = 0;
+        for (int i = 0; ok && i < xs.nruns; i += XS_FANIN) {
+            int k = xs.nruns - i < XS_FANIN ? xs.nruns - i : XS_FANIN;
+            FILE *merged = NULL;
+            ok = xs_merge(&xs, xs.runs + i, k, NULL, &merged);
+            if (ok) xs.runs[next++] = merged;
+        }
+        xs.nruns = next;
+        xs.passes++;
+    }
+
+    if (ok) {
+        if (xs.nruns > 0) {
+            ok = xs_merge(&xs, xs.runs, xs.nruns, out, NULL);
+            xs.nruns = 0;
+            xs.passes++;
+        } else {
+            qsort_r(xs.recs, xs.n, sizeof(XsRec), xs_rec_cmp, xs.arena.data);
+            ok = fputs(xs.n ? "[\n" : "[", out) >= 0;
+            for (size_t i = 0; ok && i < xs.n; i++) {
+                const XsRec *r = &xs.recs[i];
+                ok = (i ? fputs(",\n", out) >= 0 : 1) &&
+                     fwrite(xs.arena.data + r->off + r->idlen, 1, r->len, out) == r->len;
+            }
+            if (ok) ok = fputs(xs.n ? "\n]\n" : "]\n", out) >= 0;
+        }
+    }
+    free(xs.arena.data);
+    free(xs.recs);
+    if (ok) ok = fflush(out) == 0;
+    for (int i = 0; i < xs.nruns; i++) fclose(xs.runs[i]);
+    free(xs.runs);
+
+    LOG("sort: rows=%ld skipped=%ld runs=%d merge_passes=%ld spilled=%.1fMB in %.2fs (budget %zu bytes)",
+        xs.rows, xs.skipped, initial_runs, xs.passes, xs.bytes_written / 1048576.0,
+        elapsed_us_since(&t0) / 1e6, xs.budget);
+    return ok ? WRD_OK : WRD_ERR;
+}
+
+/* ----------------- request waste report (wr_daily waste) ----------------- */
+
+/*
+   Reads a --request-log and puts every request in one class, first match wins:
+     duplicate  the same URL was already answered earlier in the same run
+     avoidable  a top=1 leaderboard check whose leaderboard is fetched with top=N later
+                in the same run (that body answers it too), or a feed page whose body is
+                byte-identical to the same page in the previous run (overlap-hour rescan)
+     cacheable  same URL, same body as in some earlier run (run details and category
+                variables rarely change; unchanged leaderboards)
+     useful     everything else, failed requests included
+   then prints requests and bytes per class for each call site. Runs are delimited by
+   the log's "#run" lines; "saved" is everything but useful.
+*/
+enum { WASTE_USEFUL, WASTE_DUP, WASTE_CACHE, WASTE_AVOID, WASTE_NCLASS };
+
+typedef struct {
+    char *caller, *url;
+    long status;
+    size_t bytes;
+    uint64_t hash;
+} WasteReq;
+
+typedef struct {
+    char *caller;
+    long n[WASTE_NCLASS];
+    unsigned long long bytes[WASTE_NCLASS];
+} WasteSite;
+
+typedef struct {
+    WasteReq *reqs;
+    int n, cap;
+    WasteSite *sites;
+    int nsites;
+    StrMap siteIdx;           /* caller -> index + 1 */
+    StrSet prevBodies, allBodies;   /* "url \x1f hash" of successful responses */
+    long runs, bad_lines, avoid_top1, avoid_rescan;
+} WasteCtx;
+
+static int waste_is_feed(const char *url) {
+    return strstr(url, "/api/v1/runs?") != NULL;
+}
+
+/* top=N of a leaderboard URL (0 if not one), and the URL without it in base */
+static int waste_lb_top(const char *url, char *base, size_t basesz) {
+    if (!strstr(url, "/api/v1/leaderboards/")) return 0;
+    const char *t = strstr(url, "top=");
+    if (!t) return 0;
+    const char *e = t + 4;
+    while (*e >= '0' && *e <= '9') e++;
+    snprintf(base, basesz, "%.*s%s", (int)(t - url), url, e);
+    return atoi(t + 4);
+}
+
+static void waste_body_key(const WasteReq *r, char *out, size_t outsz) {
+    snprintf(out, outsz, "%s\x1f%016llx", r->url, (unsigned long long)r->hash);
+}
+
+static WasteSite *waste_site(WasteCtx *w, const char *caller) {
+    intptr_t idx = (intptr_t)strmap_get(&w->siteIdx, caller);
+    if (idx > 0) return &w->sites[idx - 1];
+    WasteSite *ns = realloc(w->sites, (size_t)(w->nsites + 1) * sizeof(WasteSite));
+    if (!ns) return NULL;
+    w->sites = ns;
+    WasteSite *site = &w->sites[w->nsites];
+    memset(site, 0, sizeof(*site));
+    site->caller = strdup(caller);
+    w->nsites++;
+    strmap_put(&w->siteIdx, caller, (void *)(intptr_t)w->nsites);
+    return site;
+}
+
+static void waste_classify_run(WasteCtx *w) {
+    if (w->n == 0) return;
+    w->runs++;
+
+    char key[4200], base[4200];
+    StrSet topN = {0}, answered = {0}, bodies = {0};
+    strset_init(&topN, 64);
+    strset_init(&answered, 1024);
+    strset_init(&bodies, 1024);
+
+    for (int i = 0; i < w->n; i++) {
+        WasteReq *r = &w->reqs[i];
+        if (r->status == 200 && waste_lb_top(r->url, base, sizeof(base)) > 1) strset_add(&topN, base);
+    }
+
+    for (int i = 0; i < w->n; i++) {
+        WasteReq *r = &w->reqs[i];
+        int ok = r->status == 200;
+        waste_body_key(r, key, sizeof(key));
+        int cls = WASTE_USEFUL;
+        if (ok && strset_has(&answered, r->url)) {
+            cls = WASTE_DUP;
+        } else if (waste_lb_top(r->url, base, sizeof(base)) == 1 && strset_has(&topN, base)) {
+            cls = WASTE_AVOID;
+            w->avoid_top1++;
+        } else if (ok && waste_is_feed(r->url) && strset_has(&w->prevBodies, key)) {
+            cls = WASTE_AVOID;
+            w->avoid_rescan++;
+        } else if (ok && strset_has(&w->allBodies, key)) {
+            cls = WASTE_CACHE;
+        }
+        if (ok) {
+            strset_add(&answered, r->url);
+            strset_add(&bodies, key);
+        }
+
+        WasteSite *site = waste_site(w, r->caller);
+        if (site) {
+            site->n[cls]++;
+            site->bytes[cls] += r->bytes;
+        }
+        free(r->caller);
+        free(r->url);
+    }
+    w->n = 0;
+
+    /* this run's bodies become the previous run's, and join everything seen so far */
+    for (size_t i = 0; i < bodies.cap; i++) if (bodies.keys[i]) strset_add(&w->allBodies, bodies.keys[i]);
+    strset_free(&w->prevBodies);
+    w->prevBodies = bodies;
+    strset_free(&topN);
+    strset_free(&answered);
+}
+
+static void waste_print(WasteCtx *w, FILE *out) {
+    static const char *names[WASTE_NCLASS] = { "useful", "duplicate", "cacheable", "avoidable" };
+    WasteSite total = { .caller = "total" };
+    for (int i = 0; i < w->nsites; i++) {
+        for (int c = 0; c < WASTE_NCLASS; c++) {
+            total.n[c] += w->sites[i].n[c];
+            total.bytes[c] += w->sites[i].bytes[c];
+        }
+    }
+
+    fprintf(out, "%-34s %9s", "call site", "requests");
+    for (int c = 0; c < WASTE_NCLASS; c++) fprintf(out, " %9s", names[c]);
+    fprintf(out, " %9s %6s %11s\n", "saved", "saved%", "saved KiB");
+    for (int i = 0; i <= w->nsites; i++) {
+        WasteSite *site = i < w->nsites ? &w->sites[i] : &total;
+        long all = 0, saved = 0;
+        unsigned long long saved_bytes = 0;
+        for (int c = 0; c < WASTE_NCLASS; c++) {
+            all += site->n[c];
+            if (c != WASTE_USEFUL) { saved += site->n[c]; saved_bytes += site->bytes[c]; }
+        }
+        fprintf(out, "%-34s %9ld", site->caller, all);
+        for (int c = 0; c < WASTE_NCLASS; c++) fprintf(out, " %9ld", site->n[c]);
+        fprintf(out, " %9ld %5.1f%% %11.1f\n", saved, all ? 100.0 * (double)saved / (double)all : 0.0,
+                (double)saved_bytes / 1024.0);
+    }
+    fprintf(out, "\nruns=%ld  avoidable: top=1 before top=N %ld, overlap rescans %ld",
+            w->runs, w->avoid_top1, w->avoid_rescan);
+    if (w->bad_lines) fprintf(out, "  (%ld malformed line(s) skipped)", w->bad_lines);
+    fprintf(out, "\n");
+}
+
+int wrd_waste_report(FILE *log, FILE *out) {
+    WasteCtx w;
+    memset(&w, 0, sizeof(w));
+    if (!strmap_init(&w.siteIdx, 16) || !strset_init(&w.prevBodies, 16) || !strset_init(&w.allBodies, 1024)) {
+        strmap_free(&w.siteIdx);
+        strset_free(&w.prevBodies);
+        return WRD_ERR;
+    }
+
+    int rc = WRD_OK;
+    char *line = NULL;
+    size_t linecap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &linecap, log)) > 0) {
+        if (line[len - 1] == '\n') line[--len] = '\0';
+        if (strncmp(line, "#run", 4) == 0) { waste_classify_run(&w); continue; }
+
+        char *f[6];
+        if (scan_fields(line, f, 6) != 6) { w.bad_lines++; continue; }
+        if (w.n == w.cap) {
+            int ncap = w.cap ? w.cap * 2 : 1024;
+            WasteReq *nr = realloc(w.reqs, (size_t)ncap * sizeof(WasteReq));
+            if (!nr) { rc = WRD_ERR; break; }
+            w.reqs = nr;
+            w.cap = ncap;
+        }
+        WasteReq *r = &w.reqs[w.n++];
+        r->caller = strdup(f[0]);
+        r->status = strtol(f[1], NULL, 10);
+        r->bytes = (size_t)strtoull(f[2], NULL, 10);
+        r->hash = strtoull(f[4], NULL, 16);
+        r->url = strdup(f[5]);
+        if (!r->caller || !r->url) { free(r->caller); free(r->url); w.n--; rc = WRD_ERR; break; }
+    }
+    free(line);
+    if (ferror(log)) rc = WRD_ERR;
+
+    waste_classify_run(&w);
+    if (rc == WRD_OK) waste_print(&w, out);
+
+    for (int i = 0; i < w.n; i++) { free(w.reqs[i].caller); free(w.reqs[i].url); }
+    free(w.reqs);
+    for (int i = 0; i < w.nsites; i++) free(w.sites[i].caller);
+    free(w.sites);
+    strmap_free(&w.siteIdx);
+    strset_free(&w.prevBodies);
+    strset_free(&w.allBodies);
+    return rc;
+}
+
+/* ----------------- public API (wrdaily.h) ----------------- */
+
+static time_t g_now_override = 0;
+static const char *g_force_isa = NULL;
+static const char *g_sections_path = NULL;
+static const char *g_request_log_path = NULL;
+
+struct wrd_store {
+    CURL *curl;
+    time_t now, cutoff_1h, cutoff_24h;
+    cJSON *wrs;               /* the writer's working set; readers use the published view */
+    ShardMap runIds;
+    ShardMap catCache;        /* cat_id -> VarMap* */
+    long last_seen_epoch, new_last_seen, recheck_from;
+    char *first_page;         /* feed page 0, fetched while the store loaded (prefetch_feed) */
+    time_t first_page_at;     /* wall clock when it arrived */
+    ThreadPhase load;         /* measured on the loader thread */
+};
+
+/* an opened store's prefetched feed page is only used by a wrd_update() this soon */
+#define FEED_PREFETCH_MAX_AGE_SEC 60
+
+static int g_prefetch_feed = 0;   /* wrd_options.prefetch_feed */
+
+/*
+   Store loader thread: state, change log and WR store, parsed off the main thread
+   so the API connection (DNS, TCP, TLS, h2), and with prefetch_feed the first feed
+   page, overlap it.
+   Touches only its own globals (change log, store damage) until joined.
+*/
+static void *store_load_thread(void *arg) {
+    wrd_store *s = (wrd_store *)arg;
+    thread_phase_begin(&s->load);
+    s->last_seen_epoch = load_last_seen_epoch();
+    changes_open(s->now);
+    s->wrs = load_wrs_array();
+    thread_phase_end(&s->load);
+    return NULL;
+}
+
+/* Copy options into the process-wide settings; WRD_EUSAGE with a message if invalid. */
+static int apply_options(const wrd_options *o) {
+    if (!o->layout || strcmp(o->layout, "days") == 0) g_store_layout = STORE_LAYOUT_DAYS;
+    else if (strcmp(o->layout, "json") == 0) g_store_layout = STORE_LAYOUT_JSON;
+    else { fprintf(stderr, "unknown store layout: %s\n", o->layout); return WRD_EUSAGE; }
+
+    if (!o->io || strcmp(o->io, "auto") == 0) g_io_mode = IO_MODE_AUTO;
+    else if (strcmp(o->io, "uring") == 0) g_io_mode = IO_MODE_URING;
+    else if (strcmp(o->io, "sync") == 0) g_io_mode = IO_MODE_SYNC;
+    else { fprintf(stderr, "unknown io backend: %s\n", o->io); return WRD_EUSAGE; }
+
+    if (o->faults && !faults_parse(o->faults)) { fprintf(stderr, "bad faults profile: %s\n", o->faults); return WRD_EUSAGE; }
+    if (g_faults_on && !o->replay_dir) { fprintf(stderr, "fault injection needs a replay directory\n"); return WRD_EUSAGE; }
+
+    g_record_dir = o->record_dir;
+    g_replay_dir = o->replay_dir;
+    if (o->api_base) g_api_base = o->api_base;
+    g_now_override = (time_t)o->now;
+    g_force_isa = o->force_isa;
+    if (o->queue_mem) g_queue_budget = o->queue_mem;
+    g_profile_path = o->profile_path;
+    g_metrics_path = o->metrics_path;
+    g_request_log_path = o->request_log;
+    g_counters_wanted = o->counters;
+    g_sections_path = o->sections_path;
+    if (o->jobs < 0 || o->jobs > SCAN_MAX_JOBS) {
+        fprintf(stderr, "--jobs must be 1..%d\n", SCAN_MAX_JOBS);
+        return WRD_EUSAGE;
+    }
+    g_scan_jobs = o->jobs > 0 ? o->jobs : 1;
+    if (o->request_budget < 0) { fprintf(stderr, "--request-budget must not be negative\n"); return WRD_EUSAGE; }
+    g_request_budget = o->request_budget;
+    g_precompress = o->precompress;
+    g_store_raw = o->store_raw;
+    g_mem_cgroup = o->mem_cgroup;
+    g_prefetch_feed = o->prefetch_feed;
+    return WRD_OK;
+}
+
+wrd_store *wrd_open(const wrd_options *opts, int *err) {
+    static const wrd_options defaults;
+    int dummy;
+    if (!err) err = &dummy;
+    *err = apply_options(opts ? opts : &defaults);
+    if (*err != WRD_OK) return NULL;
+
+    init_debug_from_env();
+    if (g_profile_path && !prof_start()) LOG("Profile: sampler could not be started");
+    init_tz_eastern();
+
+    *err = WRD_EUSAGE;
+    if (!isa_init(g_force_isa)) {
+        fprintf(stderr, "ISA %s is not supported on this CPU\n", g_force_isa);
+        return NULL;
+    }
+
+    *err = WRD_ERR;
+    if (!ensure_dir("data")) {
+        fprintf(stderr, "Failed to ensure ./data directory\n");
+        return NULL;
+    }
+
+    if (g_record_dir && !ensure_dir(g_record_dir)) {
+        fprintf(stderr, "Failed to ensure %s\n", g_record_dir);
+        return NULL;
+    }
+
+    wrd_store *s = (wrd_store *)calloc(1, sizeof(wrd_store));
+    if (!s) return NULL;
+    s->now = g_now_override ? g_now_override : time(NULL);
+    s->cutoff_1h  = s->now - 1 * 3600;
+    s->cutoff_24h = s->now - 24 * 3600;
+
+    LOG("Start. now=%ld cutoff_1h=%ld cutoff_24h=%ld isa=%s",
+        (long)s->now, (long)s->cutoff_1h, (long)s->cutoff_24h, g_isa->name);
+
+    if (!io_init()) {
+        fprintf(stderr, "io_uring is not available\n");
+        *err = WRD_EUSAGE;
+        free(s);
+        return NULL;
+    }
+    /* state and store reads run while curl/TLS initialise */
+    io_prefetch("data/state.json");
+    io_prefetch(CHANGES_PATH);
+    io_prefetch(PLAN_STATS_PATH);
+    store_prefetch();
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    s->curl = curl_easy_init();
+    if (!s->curl) {
+        fprintf(stderr, "curl_easy_init failed\n");
+        curl_global_cleanup();
+        free(s);
+        return NULL;
+    }
+
+    if (g_counters_wanted) counters_init();
+
+    if (g_request_log_path) {
+        g_request_log = fopen(g_request_log_path, "a");
+        if (g_request_log) fprintf(g_request_log, "#run\t%ld\t%ld\n", (long)s->now, (long)getpid());
+        else LOG("Request log: cannot open %s: %s", g_request_log_path, strerror(errno));
+    }
+
+    pthread_t loader;
+    int threaded = pthread_create(&loader, NULL, store_load_thread, s) == 0;
+    if (!threaded) store_load_thread(s);
+
+    /* page 0 does not depend on the store: it is the same request whatever last_seen is */
+    if (g_prefetch_feed) {
+        phase_begin(PHASE_SCAN);
+        char url[1024];
+        feed_page_url(url, sizeof(url), 0);
+        s->first_page = fetch_url_from(s->curl, url, "scan_new_runs_and_update", NULL); /* the scan's page */
+        s->first_page_at = time(NULL);
+        phase_end(PHASE_SCAN, 0);
+    }
+
+    if (threaded) pthread_join(loader, NULL);
+    phase_add_thread(PHASE_LOAD, &s->load, cJSON_GetArraySize(s->wrs));
+    if (g_store_lost_from > 0) {
+        s->recheck_from = g_store_lost_from > (long)s->cutoff_24h ? g_store_lost_from : (long)s->cutoff_24h;
+        LOG("Store damaged from %ld; rechecking the feed from %ld (last_seen was %ld)",
+            g_store_lost_from, s->recheck_from, s->last_seen_epoch);
+        if (s->last_seen_epoch > s->recheck_from) s->last_seen_epoch = s->recheck_from;
+    }
+    s->new_last_seen = s->last_seen_epoch;
+
+    phase_begin(PHASE_PRUNE);
+    long loaded = cJSON_GetArraySize(s->wrs);
+    prune_old_wrs(s->wrs, s->cutoff_24h);
+
+    shmap_init(&s->runIds, 2048, NULL);
+    shmap_init_lru(&s->catCache, 256, free_varmap_val);
+
+    int existing = cJSON_GetArraySize(s->wrs);
+    for (int i = 0; i < existing; i++) {
+        cJSON *it = cJSON_GetArrayItem(s->wrs, i);
+        if (!cJSON_IsObject(it)) continue;
+        const char *rid = json_get_string(it, "run_id");
+        if (rid) shmap_add(&s->runIds, rid);
+    }
+    phase_end(PHASE_PRUNE, loaded);
+
+    /* Ensure avatars show for already-saved recent entries */
+    phase_begin(PHASE_ENRICH);
+    enrich_recent_entries_with_players_data(s->curl, s->wrs, s->cutoff_24h);
+    phase_end(PHASE_ENRICH, cJSON_GetArraySize(s->wrs));
+
+    LOG("Loaded state: last_seen_epoch=%ld", s->last_seen_epoch);
+    LOG("Loaded wrs.json (post-prune): %d entries", cJSON_GetArraySize(s->wrs));
+
+    *err = WRD_OK;
+    return s;
+}
+
+int wrd_update(wrd_store *s) {
+    /* leaderboard tops are only trusted for one pass; the category cache lives on */
+    ShardMap lbCache;
+    shmap_init_lru(&lbCache, 1024, free);
+
+    /* a page prefetched by wrd_open() long ago would start the scan in the past */
+    if (s->first_page && time(NULL) - s->first_page_at > FEED_PREFETCH_MAX_AGE_SEC) {
+        LOG("Feed: prefetched page 0 is %lds old; fetching it again", (long)(time(NULL) - s->first_page_at));
+        free(s->first_page);
+        s->first_page = NULL;
+    }
+
+    phase_begin(PHASE_SCAN);
+    long seen = scan_new_runs_and_update(s->curl, &s->catCache, &lbCache, s->wrs, &s->runIds,
+                                         s->last_seen_epoch, s->recheck_from, s->cutoff_24h,
+                                         s->first_page, s->now);
+    s->first_page = NULL;
+    phase_end(PHASE_SCAN, cJSON_GetArraySize(s->wrs));
+
+    shmap_free(&lbCache);
+    if (seen < 0) return WRD_ERR;
+    if (seen > s->new_last_seen) s->new_last_seen = seen;
+    return WRD_OK;
+}
+
+/* Runs handed in from outside: no paging floor, same checks and backfill as the scan. */
+static int ingest_begin(wrd_store *s, ScanCtx *sc, ShardMap *lbCache) {
+    shmap_init_lru(lbCache, 64, free);
+    phase_begin(PHASE_SCAN);
+    scan_begin(sc, s->curl, &s->catCache, lbCache, s->wrs, &s->runIds, s->new_last_seen, s->cutoff_24h);
+    sc->recheck_from = s->recheck_from;
+    return 0;
+}
+
+static void ingest_end(wrd_store *s, ScanCtx *sc, ShardMap *lbCache) {
+    scan_process(sc);
+    long seen = scan_end(sc);
+    shmap_free(lbCache);
+    if (seen > s->new_last_seen) s->new_last_seen = seen;
+    phase_end(PHASE_SCAN, cJSON_GetArraySize(s->wrs));
+}
+
+int wrd_ingest_page(wrd_store *s, const char *json, size_t len) {
+    cJSON *root = cJSON_ParseWithLength(json, len);
+    cJSON *data = root ? cJSON_GetObjectItemCaseSensitive(root, "data") : NULL;
+    if (!cJSON_IsArray(data)) {
+        cJSON_Delete(root);
+        return -1;
+    }
+
+    ScanCtx sc;
+    ShardMap lbCache;
+    ingest_begin(s, &sc, &lbCache);
+    scan_queue_page(&sc, data, 0);
+    cJSON_Delete(root);
+    int n = (int)sc.work.pushed;
+    ingest_end(s, &sc, &lbCache);
+    return n;
+}
+
+int wrd_ingest_run(wrd_store *s, const wrd_run *run) {
+    if (!run || !run->run_id || !run->game_id || !run->category_id) return -1;
+
+    /* normalise to one compact line; the queue record is tab-separated */
+    char *values = NULL;
+    if (run->values_json) {
+        cJSON *v = cJSON_Parse(run->values_json);
+        if (!cJSON_IsObject(v)) { cJSON_Delete(v); return -1; }
+        values = cJSON_PrintUnformatted(v);
+        cJSON_Delete(v);
+    }
+
+    ScanCtx sc;
+    ShardMap lbCache;
+    ingest_begin(s, &sc, &lbCache);
+    int n = scan_queue_run(&sc, (long)run->verified_epoch, run->run_id, run->game_id,
+                           run->category_id, run->level_id, values);
+    ingest_end(s, &sc, &lbCache);
+    free(values);
+    return n;
+}
+
+void wrd_publish(wrd_store *s) {
+    view_publish(s->wrs);
+}
+
+int wrd_foreach(wrd_store *s, long long since_epoch,
+                int (*fn)(const wrd_wr *wr, void *ctx), void *ctx) {
+    (void)s;
+    const WrView *view = NULL;
+    int slot = view_pin(&view);
+    int n = view_count_since(view, (time_t)since_epoch), i = 0, visited = 0;
+    cJSON *rows = view ? view->rows : NULL;
+    cJSON *it = NULL;
+    cJSON_ArrayForEach(it, rows) {
+        if (i++ >= n) break;
+        wrd_wr wr = {
+            .run_id = json_get_string(it, "run_id"),
+            .verified_epoch = view->epochs[i - 1],
+            .verified_iso = json_get_string(it, "verified_iso"),
+            .game = json_get_string(it, "game"),
+            .game_cover = json_get_string(it, "game_cover"),
+            .category = json_get_string(it, "category"),
+            .level = json_get_string(it, "level"),
+            .subcats = json_get_string(it, "subcats"),
+            .primary_t = json_get_number(it, "primary_t", -1),
+            .players = json_get_string(it, "players"),
+            .weblink = json_get_string(it, "weblink"),
+            .raw = json_get_string(it, "raw"),
+        };
+        visited++;
+        if (fn(&wr, ctx)) break;
+    }
+    view_unpin(slot);
+    return visited;
+}
+
+char *wrd_wr_raw_json(const wrd_wr *wr, size_t *len) {
+    return wr && wr->raw ? raw_unpack(wr->raw, len) : NULL;
+}
+
+int wrd_render(wrd_store *s, FILE *out) {
+    RenderJob job = { .cutoff_1h = s->cutoff_1h, .cutoff_24h = s->cutoff_24h };
+    render_thread(&job);
+    if (!job.md) return WRD_ERR;
+    int ok = fwrite(job.md, 1, job.md_len, out) == job.md_len;
+    free(job.md);
+    return ok ? WRD_OK : WRD_ERR;
+}
+
+int wrd_commit(wrd_store *s, int render_fd) {
+    phase_begin(PHASE_SORT);
+    const WrView *view = view_publish(s->wrs);
+    int rows = view ? view->n : 0;
+    phase_end(PHASE_SORT, rows);
+
+    /* store, state and README output are written and fsynced as one batch below */
+    io_defer_writes(1);
+
+    /* render on a reader thread while this one saves the same snapshot */
+    RenderJob job = { .cutoff_1h = s->cutoff_1h, .cutoff_24h = s->cutoff_24h };
+    pthread_t renderer;
+    int threaded = 0;
+    int render = render_fd >= 0 || g_sections_path;
+    if (render) {
+        threaded = pthread_create(&renderer, NULL, render_thread, &job) == 0;
+        if (!threaded) render_thread(&job);
+    }
+
+    phase_begin(PHASE_SAVE);
+    cJSON *empty = view ? NULL : cJSON_CreateArray();
+    save_wrs_array(view ? view->rows : empty);
+    cJSON_Delete(empty);
+    save_last_seen_epoch(s->new_last_seen);
+    changes_save();
+    if (g_plan_stats) {
+        char *stats = cJSON_Print(g_plan_stats);
+        if (stats) write_file_if_changed(PLAN_STATS_PATH, stats);
+        free(stats);
+    }
+    phase_end(PHASE_SAVE, rows);
+
+    LOG("After scan: wrs.json entries=%d new_last_seen=%ld", rows, s->new_last_seen);
+
+    int rendered = 1;
+    if (render) {
+        if (threaded) pthread_join(renderer, NULL);
+        phase_add_thread(PHASE_RENDER, &job.phase, job.rows);
+        if (job.md) {
+            if (render_fd >= 0) io_queue_write("<stdout>", render_fd, job.md, job.md_len);
+            if (g_sections_path && !write_file_if_changed(g_sections_path, job.md)) rendered = 0;
+            free(job.md);
+        } else {
+            LOG("Render: no memory for the README sections");
+            rendered = 0;
+        }
+    }
+
+    phase_begin(PHASE_SAVE);
+    precompress_finish();   /* siblings join the batch, behind their files */
+    int flushed = io_flush_writes() && rendered;
+    io_defer_writes(0);
+    phase_end(PHASE_SAVE, rows);
+
+    s->last_seen_epoch = s->new_last_seen;
+    s->recheck_from = 0;
+    return flushed ? WRD_OK : WRD_ERR;
+}
+
+void wrd_close(wrd_store *s) {
+    if (!s) return;
+    precompress_finish();
+    phases_report(s->now);
+
+    view_swap(NULL);
+    free(s->first_page);
+    cJSON_Delete(s->wrs);
+    shmap_free(&s->catCache);
+    shmap_free(&s->runIds);
+    cJSON_Delete(g_plan_stats);
+    g_plan_stats = NULL;
+
+    curl_easy_cleanup(s->curl);
+    curl_global_cleanup();
+    if (g_request_log) fclose(g_request_log);
+    g_request_log = NULL;
+    free(s);
+}
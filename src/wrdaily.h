@@ -0,0 +1,162 @@
+/*
+   libwrdaily: the daily world-record tracker behind wr_daily, as a C library.
+
+   A store is the data/ directory under the current working directory (state.json,
+   store/, changes.jsonl). The library keeps process-wide state, so one store may be
+   open at a time; the calls on it must come from one thread. wrd_foreach() and
+   wrd_render() read an immutable published snapshot and may run on other threads
+   while the owner keeps ingesting.
+
+   Typical use (this is all the wr_daily CLI does):
+       wrd_store *s = wrd_open(&opts, &err);
+       wrd_update(s);                      // or wrd_ingest_page()/wrd_ingest_run()
+       wrd_commit(s, STDOUT_FILENO);       // save store + state, render sections
+       wrd_close(s);
+
+   Status codes double as the CLI's exit codes.
+*/
+#ifndef WRDAILY_H
+#define WRDAILY_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(WRD_BUILD) && defined(__GNUC__)
+#define WRD_API __attribute__((visibility("default")))
+#else
+#define WRD_API
+#endif
+
+enum {
+    WRD_OK = 0,
+    WRD_ERR = 1,         /* I/O, network or memory failure */
+    WRD_EUSAGE = 2,      /* bad option, or unsupported on this machine */
+    WRD_ESTALE = 3       /* change-log cursor older than the log */
+};
+
+typedef struct wrd_options {
+    const char *layout;        /* "days" (default) or "json" */
+    const char *record_dir;    /* save every API response here */
+    const char *replay_dir;    /* serve API requests from a recorded directory */
+    const char *faults;        /* fault profile for replays, e.g. "throttle,seed=3" */
+    const char *api_base;      /* API origin (default https://www.speedrun.com) */
+    long long now;             /* pretend time (0 = wall clock) */
+    const char *force_isa;     /* "scalar", "sse42", "avx2" (NULL = best) */
+    const char *io;            /* "auto" (NULL), "uring" or "sync" */
+    size_t queue_mem;          /* scan queue memory before spilling (0 = 4 MiB) */
+    int jobs;                  /* leaderboard checks in parallel (0 = 1) */
+    long request_budget;       /* plan the scan to fit this many API requests (0 = no limit) */
+    const char *profile_path;  /* sample the process into folded stacks */
+    const char *metrics_path;  /* per-phase timings as JSON, written by wrd_close() */
+    const char *request_log;   /* append every API request to this file (wrd_waste_report) */
+    int counters;              /* read hardware counters per phase */
+    const char *sections_path; /* wrd_commit() also writes the sections here, if changed */
+    int precompress;           /* .gz (and .zst) siblings of changed output files */
+    int store_raw;             /* keep each new WR's API run object, compressed, in the store */
+    const char *mem_cgroup;    /* cgroup dir to watch for memory pressure (NULL = own, "off") */
+    int prefetch_feed;         /* wrd_open() fetches feed page 0 while the store loads, for a
+                                  wrd_update() right after (dropped if over a minute old) */
+} wrd_options;
+
+/* One WR row, valid for the duration of a wrd_foreach() callback. */
+typedef struct wrd_wr {
+    const char *run_id;
+    long long verified_epoch;
+    const char *verified_iso;
+    const char *game;
+    const char *game_cover;
+    const char *category;
+    const char *level;         /* "" for full-game runs */
+    const char *subcats;
+    double primary_t;          /* seconds, -1 if unknown */
+    const char *players;       /* comma-separated names */
+    const char *weblink;
+    const char *raw;           /* packed API run object (--store-raw), NULL if none */
+} wrd_wr;
+
+/* A run already parsed by the caller (ids as in the speedrun.com API). */
+typedef struct wrd_run {
+    const char *run_id;
+    long long verified_epoch;
+    const char *game_id;
+    const char *category_id;
+    const char *level_id;      /* NULL for full-game runs */
+    const char *values_json;   /* the run's "values" object, NULL if none */
+} wrd_run;
+
+typedef struct wrd_store wrd_store;
+
+/* Load state and store, prune to the 24h window. NULL on failure with *err set. */
+WRD_API wrd_store *wrd_open(const wrd_options *opts, int *err);
+
+/*
+   Page the runs feed from the last seen run and add new WRs (with their history).
+   WRD_ERR if some runs could not be queued for checking; the last seen run then stays
+   put, so committing is still safe and the next update pages them again.
+*/
+WRD_API int wrd_update(wrd_store *s);
+
+/*
+   Feed runs obtained elsewhere. A page is a /api/v1/runs response body fetched with
+   embed=game,category,level; a run is the caller's own parse. New current WRs are
+   detected and backfilled exactly as by wrd_update(). Returns the number of runs
+   considered, or -1 on malformed input.
+*/
+WRD_API int wrd_ingest_page(wrd_store *s, const char *json, size_t len);
+WRD_API int wrd_ingest_run(wrd_store *s, const wrd_run *run);
+
+/* Publish pending changes for readers without saving them. */
+WRD_API void wrd_publish(wrd_store *s);
+
+/* WRs verified at or after since_epoch, newest first; stops when fn returns nonzero. */
+WRD_API int wrd_foreach(wrd_store *s, long long since_epoch,
+                        int (*fn)(const wrd_wr *wr, void *ctx), void *ctx);
+
+/* wr->raw inflated to the run's JSON as the API sent it (caller frees), or NULL. */
+WRD_API char *wrd_wr_raw_json(const wrd_wr *wr, size_t *len);
+
+/* The README sections (past hour, past 24 hours) for the published snapshot. */
+WRD_API int wrd_render(wrd_store *s, FILE *out);
+
+/*
+   Publish, then save store, state and change log while rendering the sections to
+   render_fd (-1: none) and/or sections_path on a second thread; all writes land as
+   one batch. With precompress, returns once the compressed siblings are written.
+*/
+WRD_API int wrd_commit(wrd_store *s, int render_fd);
+
+/* Report phase metrics, stop the profiler and free everything. */
+WRD_API void wrd_close(wrd_store *s);
+
+/* Change log: entries after cursor `since` to out (WRD_ESTALE if trimmed), or the head. */
+WRD_API int wrd_changes_since(long long since, FILE *out);
+WRD_API long long wrd_changes_head(void);
+
+/* Caching reverse proxy for /api/v1; serves until the listener fails. */
+typedef struct wrd_proxy_options {
+    const char *listen;        /* "HOST:PORT" (default 127.0.0.1:8787) */
+    const char *cache_dir;     /* default data/proxy-cache */
+    long interval_ms;          /* minimum gap between upstream calls (0 = 1000) */
+    const char *replay_dir;    /* upstream from a recorded directory (testing) */
+} wrd_proxy_options;
+
+WRD_API int wrd_proxy(const wrd_proxy_options *opts);
+
+/* External sort of a WR dump (JSON array or JSONL) into a newest-first array. */
+WRD_API int wrd_sort(FILE *in, FILE *out, size_t mem_budget);
+
+/* Classify a request log's requests (useful/duplicate/cacheable/avoidable) per call site. */
+WRD_API int wrd_waste_report(FILE *request_log, FILE *out);
+
+/* "64M", "512k", "1G" or plain bytes; 0 if malformed. */
+WRD_API int wrd_parse_size(const char *s, size_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WRDAILY_H */
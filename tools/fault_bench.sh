@@ -0,0 +1,61 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Run wr_daily against the replay workload under each fault profile (--faults).
+#   tools/fault_bench.sh <replay_dir> <now_epoch> <binary> [<profile>...]
+# Per profile: API throughput (requests per second of end-to-end time), completion
+# rate (requests that eventually succeeded), retries, end-to-end run time (wall time
+# + simulated network/back-off time) and whether the README sections still match the
+# fault-free replay.
+
+REPLAY_DIR="${1:-}"
+NOW="${2:-}"
+BIN="${3:-}"
+shift 3 || true
+
+if [[ -z "${REPLAY_DIR}" || -z "${NOW}" || -z "${BIN}" ]]; then
+  echo "Usage: tools/fault_bench.sh <replay_dir> <now_epoch> <binary> [<profile>...]" >&2
+  exit 2
+fi
+
+PROFILES=("$@")
+if [[ ${#PROFILES[@]} -eq 0 ]]; then
+  PROFILES=(clean slow throttle flaky5xx truncated timeouts degraded)
+fi
+
+REPLAY_DIR="$(cd "${REPLAY_DIR}" && pwd)"
+BIN="$(cd "$(dirname "${BIN}")" && pwd)/$(basename "${BIN}")"
+WORK="$(mktemp -d)"
+trap 'rm -rf "${WORK}"' EXIT
+
+# numeric field from the cJSON-printed metrics file
+metric() { sed -n "s/^[[:space:]]*\"$1\":[[:space:]]*\([0-9.e+-]*\),*$/\1/p" "$2" | head -1; }
+
+run_one() {
+  local dir="${WORK}/$1"
+  mkdir -p "${dir}"
+  local t0 t1
+  t0=$(date +%s%N)
+  (cd "${dir}" && DEBUG=0 "${BIN}" --replay="${REPLAY_DIR}" --now="${NOW}" ${2:-} \
+     --metrics=metrics.json > sections.md) || true
+  t1=$(date +%s%N)
+  echo $(( (t1 - t0) / 1000000 ))
+}
+
+run_one reference "" > /dev/null
+
+printf '%-10s %9s %9s %8s %8s %12s %8s\n' profile requests req/s done% retries e2e_s output
+for p in "${PROFILES[@]}"; do
+  wall_ms="$(run_one "${p}" "--faults=${p}")"
+  m="${WORK}/${p}/metrics.json"
+  req="$(metric requests "${m}")"
+  ok="$(metric ok "${m}")"
+  retries="$(metric retries "${m}")"
+  sim="$(metric sim_wait_ms "${m}")"
+  same=differs
+  cmp -s "${WORK}/reference/sections.md" "${WORK}/${p}/sections.md" && same=same
+  awk -v p="${p}" -v req="${req}" -v ok="${ok}" -v rt="${retries}" -v sim="${sim}" -v wall="${wall_ms}" -v same="${same}" \
+    'BEGIN { e2e = (wall + sim) / 1000.0;
+             printf "%-10s %9d %9.2f %7.1f%% %8d %12.1f %8s\n", p, req, (e2e > 0) ? req / e2e : 0,
+                    (req > 0) ? 100.0 * ok / req : 0, rt, e2e, same }'
+done
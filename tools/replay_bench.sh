@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Time wr_daily binaries against an offline replay workload.
+#   tools/replay_bench.sh <replay_dir> <now_epoch> <binary> [<binary>...]
+# Each binary runs RUNS times (default 5) from a fresh, empty data/ directory.
+# With two or more binaries, the speedup of each one over the first is reported.
+# Extra wr_daily flags can be passed in WR_ARGS (e.g. WR_ARGS=--force-isa=scalar).
+
+REPLAY_DIR="${1:-}"
+NOW="${2:-}"
+shift 2 || true
+
+if [[ -z "${REPLAY_DIR}" || -z "${NOW}" || $# -lt 1 ]]; then
+  echo "Usage: tools/replay_bench.sh <replay_dir> <now_epoch> <binary> [<binary>...]" >&2
+  exit 2
+fi
+
+RUNS="${RUNS:-5}"
+REPLAY_DIR="$(cd "${REPLAY_DIR}" && pwd)"
+
+# median wall time in milliseconds over $RUNS cold runs
+bench_one() {
+  local bin times=() work t0 t1
+  bin="$(cd "$(dirname "$1")" && pwd)/$(basename "$1")"
+  for ((i = 0; i < RUNS; i++)); do
+    work="$(mktemp -d)"
+    t0=$(date +%s%N)
+    (cd "${work}" && DEBUG=0 "${bin}" --replay="${REPLAY_DIR}" --now="${NOW}" ${WR_ARGS:-} > sections.md)
+    t1=$(date +%s%N)
+    rm -rf "${work}"
+    times+=( $(( (t1 - t0) / 1000000 )) )
+  done
+  printf '%s\n' "${times[@]}" | sort -n | awk '{ a[NR] = $1 } END { print a[int((NR + 1) / 2)] }'
+}
+
+base_ms=""
+for bin in "$@"; do
+  ms="$(bench_one "${bin}")"
+  if [[ -z "${base_ms}" ]]; then
+    base_ms="${ms}"
+    printf '%-28s %6d ms (median of %d)\n' "${bin}" "${ms}" "${RUNS}"
+  else
+    printf '%-28s %6d ms (median of %d)  speedup x%s\n' "${bin}" "${ms}" "${RUNS}" \
+      "$(awk -v a="${base_ms}" -v b="${ms}" 'BEGIN { printf "%.2f", (b > 0) ? a / b : 0 }')"
+  fi
+done